@@ -0,0 +1,507 @@
+#include <fstream>
+#include <getopt.h>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "ecoulement.h"
+
+
+/**
+ * Grille synthétique à mesurer
+ */
+struct Grille {
+    std::size_t cote;     // Largeur et hauteur
+    std::size_t marge;    // Bande isolante du pourtour, marge fixe incluse
+    double densite;       // Fraction des points qui sont des sources
+    unsigned int graine;  // Même graine, même grille
+};
+
+/**
+ * Une mesure du pas de temps d'un modèle
+ */
+struct Mesure {
+    std::string modele;
+    int nb_fils;
+    Grille grille;
+    unsigned int nb_iter;     // Itérations chronométrées
+    double secondes;          // Meilleur temps d'une itération
+    std::size_t octets_par_point;
+    double pointe;            // Débit STREAM du même nombre de fils, Go/s
+};
+
+
+/**
+ * Remplir un modèle d'une grille synthétique : conduction uniforme entre
+ * 0 et 1, sources de chaleur éparses de 128 à 255 degrés et bande de
+ * conduction nulle sur le pourtour. Les températures initiales sont
+ * celles des sources, et 20 degrés ailleurs.
+ * @param grille Paramètres de la grille
+ * @param carte Modèle à redimensionner et remplir
+ */
+template <class Modele>
+void generer(const Grille & grille, Modele & carte)
+{
+    std::mt19937 hasard(grille.graine);
+    std::uniform_real_distribution<double> uniforme(0., 1.);
+    const std::size_t n = grille.cote;
+
+    carte.redimensionner(n, n);
+
+    auto point = carte.begin();
+
+    for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = 0; j < n; ++j, ++point) {
+            const bool bord = std::min(std::min(i, n - 1 - i),
+                std::min(j, n - 1 - j)) < grille.marge;
+            const double conduction = uniforme(hasard);
+            const bool source = uniforme(hasard) < grille.densite;
+            const ctc_t chaleur = source ? 128 + 127 * uniforme(hasard) : 0;
+
+            *point = CTC {
+                chaleur,
+                source ? chaleur : ctc_t(20),
+                bord ? ctc_t(0) : ctc_t(conduction)
+            };
+        }
+    }
+}
+
+/**
+ * Débit de pointe de la mémoire, mesuré comme la triade de STREAM
+ * (a = b + s * c) sur des tableaux bien plus grands que les caches. Les
+ * octets comptés sont ceux de STREAM : deux lectures et une écriture.
+ * @param nb_elements Taille de chaque tableau
+ * @param nb_fils Nombre de fils OpenMP
+ * @return Le meilleur débit de cinq essais, en Go/s
+ */
+double debit_stream(std::size_t nb_elements, int nb_fils)
+{
+    const long n = nb_elements;
+    std::vector<double> a(n), b(n), c(n);
+    double meilleur = 0.;
+
+    // Premier contact par les fils qui feront la triade
+    #pragma omp parallel for schedule(static) num_threads(nb_fils)
+    for (long k = 0; k < n; ++k) {
+        a[k] = 0.;
+        b[k] = 1.;
+        c[k] = 2.;
+    }
+
+    for (int essai = 0; essai < 5; ++essai) {
+        const auto debut = std::chrono::steady_clock::now();
+
+        #pragma omp parallel for schedule(static) num_threads(nb_fils)
+        for (long k = 0; k < n; ++k)
+            a[k] = b[k] + 3. * c[k];
+
+        const double secondes = secondes_depuis(debut);
+
+        meilleur = std::max(meilleur, 3. * sizeof(double) * n / secondes);
+    }
+
+    // Le résultat est lu pour que la triade ne soit pas éliminée
+    if (a[n / 2] != 7.)
+        std::cerr << "Avertissement: triade incorrecte" << std::endl;
+
+    return meilleur / 1e9;
+}
+
+/**
+ * Chronométrer le pas de temps d'un modèle chargé, en séries d'au moins
+ * duree / 3 secondes après une itération d'échauffement
+ * @param carte Modèle rempli
+ * @param duree Durée minimale de la mesure, en secondes
+ * @param mesure Mesure à compléter (temps et itérations)
+ */
+template <class Modele>
+void chronometrer(Modele & carte, double duree, Mesure & mesure)
+{
+    const int nb_series = 3;
+
+    preparer(carte);
+    avancer(carte, 1);
+
+    mesure.nb_iter = 0;
+    mesure.secondes = 0.;
+
+    for (int serie = 0; serie < nb_series; ++serie) {
+        const auto debut = std::chrono::steady_clock::now();
+        unsigned int nb_iter = 0;
+        double secondes;
+
+        do {
+            avancer(carte, 1);
+            ++nb_iter;
+            synchroniser(carte);
+            secondes = secondes_depuis(debut);
+        } while (secondes < duree / nb_series);
+
+        if (serie == 0 || secondes / nb_iter < mesure.secondes)
+            mesure.secondes = secondes / nb_iter;
+        mesure.nb_iter += nb_iter;
+    }
+
+    terminer(carte);
+    mesure.octets_par_point = octets_par_point(carte);
+}
+
+/**
+ * Générer la grille d'une mesure dans le modèle demandé et le chronométrer
+ * @return false si le modèle est inconnu
+ */
+bool mesurer(const std::string & modele, double duree, Mesure & mesure)
+{
+    if (modele == "triplets") {
+        ModeleCTC carte;
+        generer(mesure.grille, carte);
+        chronometrer(carte, duree, mesure);
+    }
+    else if (modele == "plans") {
+        ModeleCTCPlans carte;
+        generer(mesure.grille, carte);
+        chronometrer(carte, duree, mesure);
+    }
+    else if (modele == "compact") {
+        ModeleCTCCompact<float> carte;
+        generer(mesure.grille, carte);
+        chronometrer(carte, duree, mesure);
+    }
+    else if (modele == "compact-f16") {
+        ModeleCTCCompact<Demi> carte;
+        generer(mesure.grille, carte);
+        chronometrer(carte, duree, mesure);
+    }
+    else if (modele == "compact-bf16") {
+        ModeleCTCCompact<BFloat16> carte;
+        generer(mesure.grille, carte);
+        chronometrer(carte, duree, mesure);
+    }
+    else if (modele == "gpu") {
+        ModeleCTCGPU carte;
+        generer(mesure.grille, carte);
+        chronometrer(carte, duree, mesure);
+    }
+    else if (modele == "damier" || modele == "simd") {
+        ModeleCTCDamier carte;
+
+        if (modele == "simd")
+            carte.activer_simd();
+        carte.activer_fils(mesure.nb_fils > 1 ? mesure.nb_fils : 0);
+        generer(mesure.grille, carte);
+        chronometrer(carte, duree, mesure);
+    }
+    else
+        return false;
+
+    return true;
+}
+
+
+/**
+ * Lire une liste d'entiers séparés par des virgules ; a-b désigne les
+ * puissances de deux de a à b
+ * @return false si la liste est invalide
+ */
+bool lire_liste(const std::string & texte, std::vector<std::size_t> & liste)
+{
+    std::istringstream champs(texte);
+    std::string champ;
+
+    liste.clear();
+    while (std::getline(champs, champ, ',')) {
+        unsigned long a, b;
+        char tiret;
+        std::istringstream intervalle(champ);
+
+        if (!(intervalle >> a) || a == 0)
+            return false;
+        if (intervalle >> tiret) {
+            if (tiret != '-' || !(intervalle >> b) || b < a)
+                return false;
+            for (; a <= b; a *= 2)
+                liste.push_back(a);
+        }
+        else
+            liste.push_back(a);
+    }
+
+    return !liste.empty();
+}
+
+/**
+ * Lire une liste de noms séparés par des virgules
+ */
+std::vector<std::string> lire_noms(const std::string & texte)
+{
+    std::istringstream champs(texte);
+    std::string champ;
+    std::vector<std::string> noms;
+
+    while (std::getline(champs, champ, ','))
+        if (!champ.empty())
+            noms.push_back(champ);
+
+    return noms;
+}
+
+/**
+ * Mémoire physique libre, en octets
+ */
+double memoire_libre()
+{
+    return (double)sysconf(_SC_AVPHYS_PAGES) * sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * Afficher une mesure sur une ligne du tableau
+ */
+void afficher(const Mesure & m)
+{
+    const double points = (double)(m.grille.cote - 2) * (m.grille.cote - 2);
+    const double go = points * m.octets_par_point / m.secondes / 1e9;
+
+    std::cout << std::left << std::setw(13) << m.modele << std::right
+        << std::setw(5) << m.nb_fils
+        << std::setw(8) << m.grille.cote
+        << std::setw(6) << m.grille.marge
+        << std::setw(8) << m.nb_iter
+        << std::fixed
+        << std::setw(10) << std::setprecision(3)
+        << m.secondes * 1e9 / points
+        << std::setw(10) << std::setprecision(3) << points / m.secondes / 1e9
+        << std::setw(9) << std::setprecision(2) << go
+        << std::setw(8) << std::setprecision(1) << 100 * go / m.pointe << "%"
+        << std::defaultfloat << std::endl;
+}
+
+/**
+ * Écrire une mesure en un objet JSON sur une ligne
+ */
+void ecrire_json(std::ostream & flux, const Mesure & m)
+{
+    const double points = (double)(m.grille.cote - 2) * (m.grille.cote - 2);
+    const double go = points * m.octets_par_point / m.secondes / 1e9;
+
+    flux.precision(9);
+    flux << "{\"modele\": ";
+    ecrire_chaine_json(flux, m.modele);
+    flux << ", \"fils\": " << m.nb_fils
+        << ", \"cote\": " << m.grille.cote
+        << ", \"marge\": " << m.grille.marge
+        << ", \"densite\": " << m.grille.densite
+        << ", \"graine\": " << m.grille.graine
+        << ", \"iterations\": " << m.nb_iter
+        << ", \"secondes_par_iteration\": " << m.secondes
+        << ", \"points_par_seconde\": " << points / m.secondes
+        << ", \"octets_par_point\": " << m.octets_par_point
+        << ", \"go_par_seconde\": " << go
+        << ", \"pointe_stream\": " << m.pointe
+        << "}" << std::endl;
+}
+
+
+/**
+ * Afficher la syntaxe d'appel du programme
+ */
+void usage(const char * programme)
+{
+    std::cerr << "Usage: " << programme << " [options]\n"
+        << "Options:\n"
+        << "  -m, --modeles L   Modèles mesurés, séparés par des virgules\n"
+        << "                    (défaut : triplets,plans,compact,\n"
+        << "                    compact-f16,compact-bf16,damier,simd ;\n"
+        << "                    gpu sur demande)\n"
+        << "  -n, --tailles L   Côtés des grilles ; a-b pour les puissances\n"
+        << "                    de deux de a à b (défaut 256-4096)\n"
+        << "  -e, --marges L    Largeurs de la bande isolante (défaut 1,32)\n"
+        << "  -t, --fils L      Nombres de fils des modèles damier et simd\n"
+        << "                    (défaut 1 à un par cœur, par puissances de 2)\n"
+        << "  -d, --densite D   Fraction des points sources (défaut 0.001)\n"
+        << "  -g, --graine G    Graine des grilles (défaut 1)\n"
+        << "  -s, --duree S     Durée minimale d'une mesure (défaut 0.5 s)\n"
+        << "  -p, --pointe P    Débit de pointe en Go/s, au lieu de le\n"
+        << "                    mesurer par la triade de STREAM\n"
+        << "  -R, --rapport F   Ajouter à F (- pour la sortie standard)\n"
+        << "                    chaque mesure en JSON, une par ligne"
+        << std::endl;
+}
+
+
+/**
+ * Programme principal
+ */
+int main(int argc, char** argv)
+{
+    std::vector<std::string> modeles {
+        "triplets", "plans", "compact", "compact-f16", "compact-bf16",
+        "damier", "simd"
+    };
+    std::vector<std::size_t> tailles, marges {1, 32}, fils;
+    double densite = 0.001;
+    unsigned int graine = 1;
+    double duree = 0.5;
+    double pointe = 0.;
+    std::string nom_rapport;
+
+    lire_liste("256-4096", tailles);
+    for (std::size_t f = 1; f <= std::thread::hardware_concurrency(); f *= 2)
+        fils.push_back(f);
+    if (fils.empty())
+        fils.push_back(1);
+
+    const struct option options[] = {
+        {"modeles", required_argument, NULL, 'm'},
+        {"tailles", required_argument, NULL, 'n'},
+        {"marges", required_argument, NULL, 'e'},
+        {"fils", required_argument, NULL, 't'},
+        {"densite", required_argument, NULL, 'd'},
+        {"graine", required_argument, NULL, 'g'},
+        {"duree", required_argument, NULL, 's'},
+        {"pointe", required_argument, NULL, 'p'},
+        {"rapport", required_argument, NULL, 'R'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "m:n:e:t:d:g:s:p:R:", options,
+                              NULL)) != -1) {
+        bool valide = true;
+
+        switch (opt) {
+        case 'm':
+            modeles = lire_noms(optarg);
+            valide = !modeles.empty();
+            break;
+        case 'n':
+            valide = lire_liste(optarg, tailles);
+            for (std::size_t n : tailles)
+                valide = valide && n >= 3;
+            break;
+        case 'e':
+            valide = lire_liste(optarg, marges);
+            break;
+        case 't':
+            valide = lire_liste(optarg, fils);
+            break;
+        case 'd':
+            densite = std::atof(optarg);
+            valide = densite >= 0 && densite <= 1;
+            break;
+        case 'g':
+            graine = std::strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            duree = std::atof(optarg);
+            valide = duree > 0;
+            break;
+        case 'p':
+            pointe = std::atof(optarg);
+            valide = pointe > 0;
+            break;
+        case 'R':
+            nom_rapport = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+
+        if (!valide) {
+            std::cerr << "Erreur: valeur invalide - " << optarg << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream fichier_rapport;
+    std::ostream * rapport = NULL;
+
+    if (nom_rapport == "-")
+        rapport = &std::cout;
+    else if (!nom_rapport.empty()) {
+        fichier_rapport.open(nom_rapport, std::ios::app);
+        if (!fichier_rapport) {
+            std::cerr << "Erreur: " << nom_rapport << " - "
+                << std::strerror(errno) << std::endl;
+            return 2;
+        }
+        rapport = &fichier_rapport;
+    }
+
+#ifndef _OPENMP
+    fils.assign(1, 1);
+#endif
+
+    // Débit de pointe de chaque nombre de fils, sur 3 x 128 Mo ; les
+    // modèles séquentiels se comparent à celui d'un fil
+    std::map<std::size_t, double> pointes;
+
+    pointes[1] = pointe;
+    for (std::size_t nb_fils : fils)
+        pointes[nb_fils] = pointe;
+    for (auto & p : pointes) {
+        if (pointe == 0.)
+            p.second = debit_stream(std::size_t(1) << 24, p.first);
+        std::cout << "Pointe STREAM (triade), " << p.first << " fils : "
+            << p.second << " Go/s" << std::endl;
+    }
+
+    // Les largeurs comptent les octets : un accent en prend deux
+    std::cout << std::left << std::setw(14) << "modèle" << std::right
+        << std::setw(5) << "fils" << std::setw(10) << "côté"
+        << std::setw(6) << "marge" << std::setw(9) << "itér."
+        << std::setw(10) << "ns/point" << std::setw(10) << "Gpts/s"
+        << std::setw(9) << "Go/s" << std::setw(9) << "pointe"
+        << std::endl;
+
+    for (const std::string & modele : modeles) {
+        const bool parallele = modele == "damier" || modele == "simd";
+
+        for (std::size_t f = 0; f < fils.size(); ++f) {
+            // Les autres modèles ne calculent qu'avec un fil
+            if (!parallele && f > 0)
+                break;
+
+            for (std::size_t n : tailles) {
+                // Trois plans de ctc_t, et une copie pour damier et gpu
+                const double besoin = 6. * sizeof(ctc_t) * n * n;
+
+                if (besoin > memoire_libre()) {
+                    std::cout << modele << " " << n << "x" << n
+                        << " : ignoré, mémoire insuffisante" << std::endl;
+                    continue;
+                }
+
+                for (std::size_t marge : marges) {
+                    Mesure mesure;
+
+                    mesure.modele = modele;
+                    mesure.nb_fils = parallele ? fils[f] : 1;
+                    mesure.grille = Grille {
+                        n, std::max<std::size_t>(marge, 1), densite, graine
+                    };
+                    mesure.pointe = pointes[mesure.nb_fils];
+
+                    if (2 * mesure.grille.marge >= n)
+                        continue;
+                    if (!mesurer(modele, duree, mesure)) {
+                        std::cerr << "Erreur: modèle inconnu - " << modele
+                            << std::endl;
+                        return 1;
+                    }
+
+                    afficher(mesure);
+                    if (rapport != NULL)
+                        ecrire_json(*rapport, mesure);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
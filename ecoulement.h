@@ -0,0 +1,5181 @@
+/**
+ * Moteur de la simulation d'écoulement de chaleur : modèles de grille,
+ * noyaux de calcul, boucle de convergence, lecture et écriture des images
+ * et des sauvegardes. Tout est en ligne ou en gabarits, pour être inclus
+ * par le programme (main.cpp) comme par la bibliothèque (ecoulement_c.cpp).
+ */
+#ifndef ECOULEMENT_H
+#define ECOULEMENT_H
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+#include <iostream>
+#include <iterator>
+#include <limits>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#include <mutex>
+#include <new>
+#include <numeric>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <png.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Les noyaux vectoriels sont écrits pour la simple précision
+#if !defined(CTC_DOUBLE) && (defined(__x86_64__) || defined(__i386__))
+#define CTC_AVX
+#elif !defined(CTC_DOUBLE) && defined(__ARM_NEON) && defined(__aarch64__)
+#define CTC_NEON
+#endif
+
+
+// Précision des calculs : double pour les validations (make double)
+#ifdef CTC_DOUBLE
+typedef double ctc_t;
+#else
+typedef float ctc_t;
+#endif
+
+// Valeurs par défaut de la configuration
+const ctc_t BRUIT = 6.4 / 256;  // 6.4 unités de la résolution de 8 bits
+const ctc_t SEUIL_CONVERGENCE = 0.5 / 256;  // 0.5 unité par pixel
+const unsigned int NB_MAX_ITER = 5000; // Limiter le temps de calcul
+const unsigned int NB_PAS_SOMMEIL = 4;  // Itérations calmes avant sommeil
+const ctc_t APPROCHE_CONVERGENCE = 2;  // Seuils d'un lot peut-être le dernier
+const unsigned int FENETRE_CONVERGENCE = 16;  // Lots de l'estimation du taux
+const double FACTEUR_EXTRAPOLATION_MAX = 64;  // Saut maximal d'une extrapolation
+
+
+/**
+ * Mesure de la variation d'une itération comparée au seuil de convergence
+ */
+enum CritereConvergence {
+    CRITERE_MOYENNE,  // Variation moyenne par point de la grille
+    CRITERE_MAX       // Plus grande variation d'un point (norme L∞)
+};
+
+
+/**
+ * Paramètres d'exécution du solveur, transmis aux modèles par configurer()
+ * et à la boucle de convergence
+ */
+struct Configuration {
+    Configuration():
+        bruit(BRUIT), seuil_convergence(SEUIL_CONVERGENCE),
+        nb_max_iter(NB_MAX_ITER), bloc(1), nb_niveaux(0), instantanes(0),
+        motif_instantanes("instantane-%05u.png"), periode_sauvegarde(0),
+        compteurs(false), critere(CRITERE_MOYENNE), tolerance_restante(0),
+        fenetre(FENETRE_CONVERGENCE), extrapolation(false) {}
+
+    /**
+     * Seuil de variation moyenne sous lequel une tuile active s'endort
+     */
+    inline ctc_t seuil_sommeil() const { return seuil_convergence / 4; }
+
+    ctc_t bruit;                // Ajouté à la moyenne des voisins
+    ctc_t seuil_convergence;    // Variation d'un modèle stabilisé (critere)
+    unsigned int nb_max_iter;   // Limite du nombre d'itérations
+    unsigned int bloc;          // Itérations entre deux tests de convergence
+    unsigned int nb_niveaux;    // Grilles grossières résolues au préalable
+    unsigned int instantanes;   // Itérations entre deux instantanés, 0 sans
+    std::string motif_instantanes;  // Nom des instantanés (printf, %u)
+    std::string sauvegarde;     // Fichier de sauvegarde, vide sans
+    unsigned int periode_sauvegarde;  // Itérations entre deux sauvegardes
+    std::string reprise;        // Sauvegarde à reprendre au lieu d'une image
+    bool compteurs;             // Compteurs matériels pendant la convergence
+    CritereConvergence critere; // Variation comparée au seuil
+    ctc_t tolerance_restante;   // Variation restante prévue d'un arrêt
+                                // anticipé, 0 sans
+    unsigned int fenetre;       // Lots de l'estimation du taux de convergence
+    bool extrapolation;         // Extrapoler les températures (Aitken)
+};
+
+
+/**
+ * Secondes écoulées depuis un instant donné
+ */
+inline double secondes_depuis(std::chrono::steady_clock::time_point debut)
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - debut).count();
+}
+
+
+/**
+ * Phases chronométrées d'un calcul, dans l'ordre du rapport
+ */
+enum PhaseCalcul {
+    PHASE_LECTURE,      // Lecture du PNG ou de la sauvegarde
+    PHASE_CONVERSION,   // Pixels ou plans sauvegardés vers le modèle
+    PHASE_MULTIGRILLE,  // Grilles grossières
+    PHASE_CONVERGENCE,  // Boucle principale, sauvegardes comprises
+    PHASE_MINMAX,       // Températures extrêmes
+    PHASE_COLORATION,   // Températures vers pixels RGB
+    PHASE_ECRITURE,     // Compression et écriture du PNG
+    NB_PHASES
+};
+
+const char * const NOMS_PHASES[NB_PHASES] = {
+    "lecture", "conversion", "multigrille", "convergence", "minmax",
+    "coloration", "ecriture"
+};
+
+
+/**
+ * Compteurs matériels du processeur lus par perf_event_open(2), sans
+ * bibliothèque : cycles, instructions et défauts de la cache de dernier
+ * niveau, en mode utilisateur. Un compteur compte le fil qui l'ouvre et
+ * les fils créés ensuite ; l'équipe OpenMP doit donc naître après
+ * l'ouverture pour être comptée.
+ */
+class CompteursMateriels
+{
+public:
+    static const int NB_COMPTEURS = 3;
+
+    CompteursMateriels() {
+        std::fill(descripteurs, descripteurs + NB_COMPTEURS, -1);
+    }
+
+    ~CompteursMateriels() {
+        for (int k = 0; k < NB_COMPTEURS; ++k)
+            if (descripteurs[k] >= 0)
+                close(descripteurs[k]);
+    }
+
+    /**
+     * Ouvrir les compteurs, arrêtés
+     * @return false si le noyau ou la machine n'en offre pas
+     */
+    bool ouvrir() {
+#ifdef __linux__
+        static const std::uint64_t evenements[NB_COMPTEURS] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES
+        };
+
+        for (int k = 0; k < NB_COMPTEURS; ++k) {
+            perf_event_attr attr;
+
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = evenements[k];
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            descripteurs[k] = syscall(SYS_perf_event_open, &attr, 0, -1,
+                                      -1, 0);
+            if (descripteurs[k] < 0)
+                return false;
+        }
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void demarrer() {
+#ifdef __linux__
+        for (int k = 0; k < NB_COMPTEURS; ++k)
+            ioctl(descripteurs[k], PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    void arreter() {
+#ifdef __linux__
+        for (int k = 0; k < NB_COMPTEURS; ++k)
+            ioctl(descripteurs[k], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+    }
+
+    /**
+     * Lire les compteurs ouverts
+     * @param valeurs Valeurs des NB_COMPTEURS compteurs
+     * @return false si une lecture échoue
+     */
+    bool lire(std::uint64_t * valeurs) const {
+        for (int k = 0; k < NB_COMPTEURS; ++k) {
+            if (read(descripteurs[k], &valeurs[k], sizeof(valeurs[k])) !=
+                sizeof(valeurs[k]))
+                return false;
+        }
+
+        return true;
+    }
+
+    static const char * nom(int k) {
+        static const char * const noms[NB_COMPTEURS] = {
+            "cycles", "instructions", "defauts_cache"
+        };
+
+        return noms[k];
+    }
+
+private:
+    CompteursMateriels(const CompteursMateriels &);
+    CompteursMateriels & operator=(const CompteursMateriels &);
+
+    int descripteurs[NB_COMPTEURS];
+};
+
+
+/**
+ * Écrire une chaîne JSON entre guillemets, échappée
+ */
+inline void ecrire_chaine_json(std::ostream & flux, const std::string & s)
+{
+    flux << '"';
+    for (const char c : s) {
+        if (c == '"' || c == '\\')
+            flux << '\\' << c;
+        else if ((unsigned char)c < 0x20) {
+            char code[8];
+
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            flux << code;
+        }
+        else
+            flux << c;
+    }
+    flux << '"';
+}
+
+/**
+ * Mesures d'un calcul : durée des phases, débit de la boucle principale
+ * et compteurs matériels, rapportés en JSON pour suivre les régressions
+ */
+struct RapportCalcul {
+    RapportCalcul():
+        largeur(0), hauteur(0), nb_iter(0), nb_iter_calculees(0),
+        delta_temp(0), t_min(0), t_max(0), taux_convergence(1),
+        arret_anticipe(false), nb_extrapolations(0), octets_par_point(0),
+        compteurs_lus(false) {
+        std::fill(secondes, secondes + NB_PHASES, 0.);
+        std::fill(compteurs, compteurs + CompteursMateriels::NB_COMPTEURS, 0);
+    }
+
+    /**
+     * Points mis à jour par seconde dans la boucle principale : tous les
+     * points intérieurs à chaque itération, tuiles endormies comprises
+     */
+    double points_par_seconde() const {
+        const double duree = secondes[PHASE_CONVERGENCE];
+        const double points = (double)(largeur - 2) * (hauteur - 2);
+
+        return duree > 0 && largeur > 2 && hauteur > 2 ?
+            points * nb_iter_calculees / duree : 0.;
+    }
+
+    /**
+     * Débit mémoire effectif de la boucle principale, en Go/s, selon
+     * les octets qu'une mise à jour doit au minimum échanger
+     */
+    double go_par_seconde() const {
+        return points_par_seconde() * octets_par_point / 1e9;
+    }
+
+    /**
+     * Écrire le rapport en un objet JSON sur une ligne
+     * @param flux Flux de destination
+     * @param entree Image ou sauvegarde des conditions initiales
+     * @param modele Nom du modèle de grille utilisé
+     */
+    void ecrire_json(std::ostream & flux, const std::string & entree,
+                     const std::string & modele) const {
+        const std::streamsize precision = flux.precision(9);
+        double total = 0.;
+
+        flux << "{\"entree\": ";
+        ecrire_chaine_json(flux, entree);
+        flux << ", \"modele\": ";
+        ecrire_chaine_json(flux, modele);
+        flux << ", \"largeur\": " << largeur
+            << ", \"hauteur\": " << hauteur
+            << ", \"iterations\": " << nb_iter
+            << ", \"iterations_calculees\": " << nb_iter_calculees
+            << ", \"ajustement_moyen\": " << delta_temp * 256
+            << ", \"t_min\": " << t_min
+            << ", \"t_max\": " << t_max
+            << ", \"taux_convergence\": ";
+        if (taux_convergence < 1)
+            flux << taux_convergence;
+        else
+            flux << "null";
+        flux << ", \"arret_anticipe\": "
+            << (arret_anticipe ? "true" : "false")
+            << ", \"extrapolations\": " << nb_extrapolations
+            << ", \"phases\": {";
+        for (int p = 0; p < NB_PHASES; ++p) {
+            flux << (p ? ", \"" : "\"") << NOMS_PHASES[p] << "\": "
+                << secondes[p];
+            total += secondes[p];
+        }
+        flux << "}, \"total\": " << total
+            << ", \"points_par_seconde\": " << points_par_seconde()
+            << ", \"octets_par_point\": " << octets_par_point
+            << ", \"go_par_seconde\": " << go_par_seconde()
+            << ", \"compteurs\": ";
+        if (compteurs_lus) {
+            for (int k = 0; k < CompteursMateriels::NB_COMPTEURS; ++k) {
+                flux << (k ? ", \"" : "{\"") << CompteursMateriels::nom(k)
+                    << "\": " << compteurs[k];
+            }
+            flux << "}";
+        }
+        else
+            flux << "null";
+        flux << "}" << std::endl;
+
+        flux.precision(precision);
+    }
+
+    std::size_t largeur;
+    std::size_t hauteur;
+    unsigned int nb_iter;            // Itérations au total, reprise incluse
+    unsigned int nb_iter_calculees;  // Itérations de cette exécution
+    double delta_temp;
+    double t_min;
+    double t_max;
+    double taux_convergence;         // Par itération, 1 s'il n'est pas estimé
+    bool arret_anticipe;             // Arrêt sur la variation restante prévue
+    unsigned int nb_extrapolations;
+    double secondes[NB_PHASES];
+    std::size_t octets_par_point;
+    bool compteurs_lus;
+    std::uint64_t compteurs[CompteursMateriels::NB_COMPTEURS];
+};
+
+
+/**
+ * Classe facilitant la lecture-écriture (Le) de fichiers PNG en RGB
+ */
+class LePNG: public std::vector<png_color>
+{
+public:
+    LePNG() {
+        memset(&entete, 0, sizeof entete);
+
+        entete.format = PNG_FORMAT_RGB;
+        entete.version = PNG_IMAGE_VERSION;
+    }
+
+    virtual ~LePNG() {
+        png_image_free(&entete);
+    }
+
+    /**
+     * Charger une image d'un fichier PNG - Triple canal (Red, Green, Blue)
+     */
+    void charger(const std::string & nom_fichier) {
+        if (!png_image_begin_read_from_file(&entete, nom_fichier.c_str()))
+            throw nom_fichier + " - " + entete.message;
+
+        // La lecture de l'en-tête donne le format du fichier
+        entete.format = PNG_FORMAT_RGB;
+        resize(entete.width * entete.height);
+
+        if (!png_image_finish_read(&entete, NULL, data(), 0, NULL))
+            throw nom_fichier + " - " + entete.message;
+    }
+
+    /**
+     * Enregistrer le résultat dans un fichier PNG
+     */
+    void enregistrer(const std::string & nom_fichier) {
+        if (!png_image_write_to_file(
+                &entete, nom_fichier.c_str(), 0, data(), 0, NULL)) {
+            throw nom_fichier + " - " + entete.message;
+        }
+    }
+
+    inline png_uint_32 largeur() const { return entete.width; }
+    inline png_uint_32 hauteur() const { return entete.height; }
+
+private:
+    png_image entete;
+};
+
+
+/**
+ * Lecture d'un fichier PNG rangée par rangée (libpng de bas niveau) : seule
+ * la rangée courante est décodée en mémoire. Les erreurs de libpng
+ * reviennent par longjmp dans la méthode appelante, qui lance le message.
+ */
+class LecteurPNG
+{
+public:
+    LecteurPNG(): fichier(NULL), png(NULL), info(NULL) {}
+
+    virtual ~LecteurPNG() {
+        png_destroy_read_struct(&png, &info, NULL);
+        if (fichier != NULL)
+            std::fclose(fichier);
+    }
+
+    LecteurPNG(const LecteurPNG &) = delete;
+    LecteurPNG & operator=(const LecteurPNG &) = delete;
+
+    /**
+     * Ouvrir un fichier PNG et en lire l'en-tête
+     * @return Faux si l'image n'est pas en RGB de 8 bits non entrelacé :
+     *         LePNG doit alors la décoder en entier et la convertir
+     */
+    bool ouvrir(const std::string & nom_fichier) {
+        nom = nom_fichier;
+        fichier = std::fopen(nom.c_str(), "rb");
+        if (fichier == NULL)
+            throw nom + " - " + std::strerror(errno);
+
+        png = png_create_read_struct(PNG_LIBPNG_VER_STRING, this,
+                                     &LecteurPNG::erreur, NULL);
+        info = png != NULL ? png_create_info_struct(png) : NULL;
+        if (info == NULL)
+            throw nom + " - mémoire insuffisante";
+
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - " + message;
+
+        png_init_io(png, fichier);
+        png_read_info(png, info);
+
+        return png_get_color_type(png, info) == PNG_COLOR_TYPE_RGB &&
+            png_get_bit_depth(png, info) == 8 &&
+            png_get_interlace_type(png, info) == PNG_INTERLACE_NONE;
+    }
+
+    /**
+     * Décoder la rangée suivante
+     * @param rangee Pixels de la rangée, largeur() éléments
+     */
+    void lire_rangee(png_color * rangee) {
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - " + message;
+
+        png_read_row(png, reinterpret_cast<png_bytep>(rangee), NULL);
+    }
+
+    inline png_uint_32 largeur() const {
+        return png_get_image_width(png, info);
+    }
+    inline png_uint_32 hauteur() const {
+        return png_get_image_height(png, info);
+    }
+
+private:
+    static void erreur(png_structp png, png_const_charp texte) {
+        static_cast<LecteurPNG *>(png_get_error_ptr(png))->message = texte;
+        png_longjmp(png, 1);
+    }
+
+    std::string nom;
+    std::string message;  // Dernière erreur de libpng
+    std::FILE * fichier;
+    png_structp png;
+    png_infop info;
+};
+
+
+/**
+ * Écriture d'un fichier PNG en RGB rangée par rangée (libpng de bas
+ * niveau), sans image complète en mémoire. Le fichier produit a les mêmes
+ * pixels et le même bloc sRGB que LePNG::enregistrer().
+ */
+class EcrivainPNG
+{
+public:
+    EcrivainPNG(): fichier(NULL), png(NULL), info(NULL) {}
+
+    virtual ~EcrivainPNG() {
+        png_destroy_write_struct(&png, &info);
+        if (fichier != NULL)
+            std::fclose(fichier);
+    }
+
+    EcrivainPNG(const EcrivainPNG &) = delete;
+    EcrivainPNG & operator=(const EcrivainPNG &) = delete;
+
+    /**
+     * Créer le fichier et en écrire l'en-tête
+     */
+    void ouvrir(const std::string & nom_fichier,
+                png_uint_32 larg, png_uint_32 haut) {
+        nom = nom_fichier;
+        fichier = std::fopen(nom.c_str(), "wb");
+        if (fichier == NULL)
+            throw nom + " - " + std::strerror(errno);
+
+        png = png_create_write_struct(PNG_LIBPNG_VER_STRING, this,
+                                      &EcrivainPNG::erreur, NULL);
+        info = png != NULL ? png_create_info_struct(png) : NULL;
+        if (info == NULL)
+            throw nom + " - mémoire insuffisante";
+
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - " + message;
+
+        png_init_io(png, fichier);
+        png_set_IHDR(png, info, larg, haut, 8, PNG_COLOR_TYPE_RGB,
+                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                     PNG_FILTER_TYPE_DEFAULT);
+        png_set_sRGB(png, info, PNG_sRGB_INTENT_PERCEPTUAL);
+        png_write_info(png, info);
+    }
+
+    /**
+     * Compresser la rangée suivante
+     * @param rangee Pixels de la rangée, de la largeur de l'image
+     */
+    void ecrire_rangee(const png_color * rangee) {
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - " + message;
+
+        png_write_row(png, reinterpret_cast<png_const_bytep>(rangee));
+    }
+
+    /**
+     * Terminer l'image une fois toutes les rangées écrites, et fermer
+     * le fichier
+     */
+    void fermer() {
+        if (setjmp(png_jmpbuf(png)))
+            throw nom + " - " + message;
+
+        png_write_end(png, info);
+
+        const int resultat = std::fclose(fichier);
+
+        fichier = NULL;
+        if (resultat != 0)
+            throw nom + " - " + std::strerror(errno);
+    }
+
+private:
+    static void erreur(png_structp png, png_const_charp texte) {
+        static_cast<EcrivainPNG *>(png_get_error_ptr(png))->message = texte;
+        png_longjmp(png, 1);
+    }
+
+    std::string nom;
+    std::string message;  // Dernière erreur de libpng
+    std::FILE * fichier;
+    png_structp png;
+    png_infop info;
+};
+
+
+/**
+ * Triplet (Chaleur, Température, Conduction)
+ */
+typedef struct {
+    ctc_t chaleur;      // Intensité de la source de chaleur
+    ctc_t temperature;  // Température en degrés Celsius
+    ctc_t conduction;   // Facteur de conduction de chaleur
+} CTC;
+
+
+/**
+ * Accès à un élément d'un vecteur, avec vérification de l'indice
+ * seulement si le programme est compilé en mode DEBUG (make debug)
+ */
+template <class Vecteur>
+inline auto element(Vecteur & v, std::size_t k) -> decltype(v[k])
+{
+#ifdef DEBUG
+    return v.at(k);
+#else
+    return v[k];
+#endif
+}
+
+
+/**
+ * Allocateur des plans de la grille. Les éléments ne reçoivent pas de
+ * valeur initiale : la première écriture de chaque page (first touch),
+ * qui la place sur le nœud NUMA du fil qui l'écrit, revient ainsi au
+ * chargement ou au fil qui la calculera, plutôt qu'au remplissage de
+ * zéros du redimensionnement. Les allocations d'au moins une page énorme
+ * y sont alignées et marquées pour les pages énormes transparentes, ce
+ * qui réduit les défauts de TLB du stencil.
+ */
+template <class T>
+struct AllocateurGrille {
+    typedef T value_type;
+
+    static const std::size_t PAGE_ENORME = 2 << 20;  // 2 Mo sur x86-64
+    static const std::size_t ALIGNEMENT = 64;        // Ligne de cache
+
+    AllocateurGrille() {}
+    template <class U>
+    AllocateurGrille(const AllocateurGrille<U> &) {}
+
+    T * allocate(std::size_t n) {
+        const std::size_t octets = n * sizeof(T);
+        const bool enorme = octets >= PAGE_ENORME;
+        void * p = NULL;
+
+        if (posix_memalign(&p, enorme ? PAGE_ENORME : ALIGNEMENT, octets))
+            throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        // Simple conseil : sans pages énormes, la mémoire reste valide
+        if (enorme)
+            madvise(p, octets, MADV_HUGEPAGE);
+#endif
+
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T * p, std::size_t) {
+        std::free(p);
+    }
+
+    /**
+     * Initialisation par défaut, sans valeur pour les types simples
+     */
+    template <class U>
+    void construct(U * p) {
+        ::new((void *)p) U;
+    }
+    template <class U, class... Arguments>
+    void construct(U * p, Arguments &&... arguments) {
+        ::new((void *)p) U(std::forward<Arguments>(arguments)...);
+    }
+};
+
+template <class T, class U>
+inline bool operator==(const AllocateurGrille<T> &, const AllocateurGrille<U> &)
+{
+    return true;
+}
+
+template <class T, class U>
+inline bool operator!=(const AllocateurGrille<T> &, const AllocateurGrille<U> &)
+{
+    return false;
+}
+
+/**
+ * Plan de la grille, sans valeurs initiales
+ */
+template <class T>
+using VecteurGrille = std::vector<T, AllocateurGrille<T> >;
+
+
+/**
+ * Répartition des fils sur les processeurs permis au processus
+ */
+enum Epinglage {
+    EPINGLAGE_AUCUN,
+    EPINGLAGE_PROCHE,   // Processeurs consécutifs : un socket après l'autre
+    EPINGLAGE_REPARTI   // Processeurs espacés : tous les sockets à la fois
+};
+
+/**
+ * Processeurs permis au processus courant, dans l'ordre de leur numéro
+ */
+inline std::vector<int> processeurs_permis()
+{
+    std::vector<int> processeurs;
+#ifdef __linux__
+    cpu_set_t permis;
+
+    if (sched_getaffinity(0, sizeof permis, &permis) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &permis))
+                processeurs.push_back(c);
+        }
+    }
+#endif
+
+    return processeurs;
+}
+
+/**
+ * Processeur d'un fil selon le mode d'épinglage
+ * @param fil Numéro du fil, de 0 à nb_fils - 1
+ * @param nb_fils Nombre de fils à répartir
+ * @param processeurs Processeurs permis, non vide
+ * @param mode EPINGLAGE_PROCHE ou EPINGLAGE_REPARTI
+ */
+inline int processeur_du_fil(int fil, int nb_fils,
+                             const std::vector<int> & processeurs,
+                             Epinglage mode)
+{
+    const std::size_t nb = processeurs.size();
+    const std::size_t rang = mode == EPINGLAGE_REPARTI ?
+        (std::size_t)fil * nb / std::max(nb_fils, 1) : (std::size_t)fil;
+
+    return processeurs[rang % nb];
+}
+
+/**
+ * Épingler chaque fil d'une équipe OpenMP sur un processeur. Les fils
+ * d'OpenMP sont réutilisés d'une région parallèle à l'autre : ceux des
+ * régions suivantes, jusqu'à nb_fils, gardent leur processeur. À épingler
+ * avant le redimensionnement, pour que les pages touchées par chaque fil
+ * soient placées sur son nœud.
+ * @param nb_fils Nombre de fils de l'équipe
+ * @param mode Répartition des fils
+ * @return Faux si l'épinglage n'est pas possible sur ce système
+ */
+inline bool epingler_fils(int nb_fils, Epinglage mode)
+{
+    if (mode == EPINGLAGE_AUCUN)
+        return true;
+
+#ifdef __linux__
+    const std::vector<int> processeurs = processeurs_permis();
+    int echecs = 0;
+
+    if (processeurs.empty())
+        return false;
+
+    #pragma omp parallel num_threads(nb_fils) reduction(+: echecs)
+    {
+#ifdef _OPENMP
+        const int fil = omp_get_thread_num();
+#else
+        const int fil = 0;
+#endif
+        cpu_set_t processeur;
+
+        CPU_ZERO(&processeur);
+        CPU_SET(processeur_du_fil(fil, nb_fils, processeurs, mode),
+                &processeur);
+        echecs += pthread_setaffinity_np(pthread_self(), sizeof processeur,
+                                         &processeur) != 0;
+    }
+
+    return echecs == 0;
+#else
+    return false;
+#endif
+}
+
+
+/**
+ * Somme compensée (Kahan-Babuška-Neumaier) des sommes partielles des
+ * variations : les balayages additionnent les variations d'une rangée
+ * dans un accumulateur simple, qui se vectorise, puis ajoutent la somme
+ * de la rangée avec correction de l'erreur d'arrondi. Sur une grande
+ * grille, la somme totale garde ainsi la précision d'une seule rangée.
+ * Le résultat ne dépend que de l'ordre d'ajout des parties.
+ */
+class SommeCompensee
+{
+public:
+    SommeCompensee(): somme(0.), correction(0.) {}
+
+    /**
+     * Ajouter une somme partielle
+     */
+    inline void ajouter(ctc_t partielle) {
+        const ctc_t total = somme + partielle;
+
+        if (std::abs(somme) >= std::abs(partielle))
+            correction += (somme - total) + partielle;
+        else
+            correction += (partielle - total) + somme;
+        somme = total;
+    }
+
+    inline ctc_t valeur() const { return somme + correction; }
+
+private:
+    ctc_t somme;
+    ctc_t correction;  // Erreur d'arrondi accumulée par les ajouts
+};
+
+
+/**
+ * Statistiques d'une itération, accumulées pendant le balayage même :
+ * températures extrêmes de toute la grille et plus grande variation d'un
+ * point (norme L∞). Elles évitent de reparcourir la grille pour étalonner
+ * la palette, et servent au critère de convergence CRITERE_MAX.
+ */
+struct StatistiquesPas {
+    StatistiquesPas():
+        t_min(std::numeric_limits<ctc_t>::infinity()),
+        t_max(-std::numeric_limits<ctc_t>::infinity()), delta_max(0.) {}
+
+    /**
+     * Inclure la température d'un point
+     */
+    inline void inclure(ctc_t temp) {
+        t_min = std::min(t_min, temp);
+        t_max = std::max(t_max, temp);
+    }
+
+    /**
+     * Inclure un point mis à jour
+     * @param temp Nouvelle température du point
+     * @param delta_temp Variation de sa température
+     */
+    inline void inclure(ctc_t temp, ctc_t delta_temp) {
+        inclure(temp);
+        delta_max = std::max(delta_max, std::abs(delta_temp));
+    }
+
+    /**
+     * Ajouter les statistiques d'une autre partie de la grille ; le
+     * résultat ne dépend pas de l'ordre des parties
+     */
+    inline void fusionner(const StatistiquesPas & autre) {
+        t_min = std::min(t_min, autre.t_min);
+        t_max = std::max(t_max, autre.t_max);
+        delta_max = std::max(delta_max, autre.delta_max);
+    }
+
+    /**
+     * Faux tant qu'aucun point n'a été inclus
+     */
+    inline bool valides() const { return t_min <= t_max; }
+
+    ctc_t t_min;
+    ctc_t t_max;
+    ctc_t delta_max;  // Plus grande variation absolue d'un point
+};
+
+
+/**
+ * Inclure une rangée mise à jour dans les statistiques
+ * @param nouvelles Températures après la mise à jour
+ * @param anciennes Températures avant la mise à jour
+ * @param n Nombre de points
+ * @param stats Statistiques à compléter
+ */
+inline void inclure_rangee(const ctc_t * nouvelles, const ctc_t * anciennes,
+                           std::size_t n, StatistiquesPas & stats)
+{
+    // Accumulateurs locaux, que les rangées ne peuvent pas recouvrir
+    ctc_t t_min = stats.t_min;
+    ctc_t t_max = stats.t_max;
+    ctc_t delta_max = stats.delta_max;
+
+    for (std::size_t k = 0; k < n; ++k) {
+        t_min = std::min(t_min, nouvelles[k]);
+        t_max = std::max(t_max, nouvelles[k]);
+        delta_max = std::max(delta_max, std::abs(nouvelles[k] - anciennes[k]));
+    }
+
+    stats.t_min = t_min;
+    stats.t_max = t_max;
+    stats.delta_max = delta_max;
+}
+
+
+/**
+ * Inclure dans les statistiques les températures de la marge de 1 pixel,
+ * que les balayages ne mettent pas à jour
+ */
+template <class Modele>
+void inclure_marge(const Modele & carte, StatistiquesPas & stats)
+{
+    const std::size_t larg = carte.largeur();
+    const std::size_t haut = carte.hauteur();
+
+    for (std::size_t j = 0; j < larg; ++j) {
+        stats.inclure(carte.temperature(0, j));
+        stats.inclure(carte.temperature(haut - 1, j));
+    }
+    for (std::size_t i = 1; i < haut - 1; ++i) {
+        stats.inclure(carte.temperature(i, 0));
+        stats.inclure(carte.temperature(i, larg - 1));
+    }
+}
+
+
+/**
+ * Modèle de grille 2D de valeurs de chaleur, température et conduction
+ */
+class ModeleCTC: public VecteurGrille<CTC>
+{
+public:
+    ModeleCTC(): larg(0), haut(0), bruit(BRUIT) {}
+
+    /**
+     * Appliquer les paramètres d'exécution au modèle
+     */
+    void configurer(const Configuration & config) {
+        bruit = config.bruit;
+    }
+
+    /**
+     * Redimensionner la grille
+     */
+    void redimensionner(std::size_t largeur, std::size_t hauteur) {
+        larg = largeur;
+        haut = hauteur;
+
+        resize(larg * haut);
+    }
+
+    /**
+     * Accès à un triplet (Chaleur, Température, Conduction)
+     */
+    inline CTC& ctc(std::size_t rangee, std::size_t colonne) {
+        return element(*this, rangee * larg + colonne);
+    }
+    inline const CTC& ctc(std::size_t rangee, std::size_t colonne) const {
+        return element(*this, rangee * larg + colonne);
+    }
+
+    /**
+     * Accès à une composante
+     */
+    inline ctc_t chaleur(std::size_t rangee, std::size_t colonne) const {
+        return element(*this, rangee * larg + colonne).chaleur;
+    }
+    inline ctc_t temperature(std::size_t rangee, std::size_t colonne) const {
+        return element(*this, rangee * larg + colonne).temperature;
+    }
+    inline ctc_t conduction(std::size_t rangee, std::size_t colonne) const {
+        return element(*this, rangee * larg + colonne).conduction;
+    }
+
+    inline std::size_t largeur() const { return larg; }
+    inline std::size_t hauteur() const { return haut; }
+
+    /**
+     * Effectuer une itération d'écoulement de chaleur sur toute la grille
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps() {
+        return balayer<false>(NULL);
+    }
+
+    /**
+     * Effectuer une itération en accumulant ses statistiques
+     * @param stats Statistiques à compléter
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps(StatistiquesPas & stats) {
+        inclure_marge(*this, stats);
+        return balayer<true>(&stats);
+    }
+
+private:
+    std::size_t larg;
+    std::size_t haut;
+    ctc_t bruit;  // Bruit ajouté à la moyenne des températures voisines
+
+    /**
+     * Balayer la grille en damier
+     * @tparam Stats Vrai pour accumuler aussi les statistiques
+     * @param stats Statistiques à compléter si Stats
+     * @return La différence de température moyenne
+     */
+    template <bool Stats>
+    ctc_t balayer(StatistiquesPas * stats) {
+        StatistiquesPas locales;
+        SommeCompensee somme_delta;
+
+        // Converge plus vite si on traite en damier (une couleur à la fois)
+        for (auto impair = 0; impair < 2; ++impair) {
+            // Laisser faire la marge de 1 pixel
+            for (std::size_t i = 1; i < haut - 1; ++i) {
+                auto depart = (((i + 1) ^ impair) & 1);  // Damier
+                ctc_t somme_rangee = 0.;
+#ifdef DEBUG
+                for (std::size_t j = 1 + depart; j < larg - 1; j += 2) {
+                    ctc_t conduct = conduction(i, j);
+                    ctc_t ancienne_temp = temperature(i, j);
+                    ctc_t nouvelle_temp = std::max(chaleur(i, j), (
+                        temperature(i - 1, j) +
+                        temperature(i, j - 1) +
+                        temperature(i, j + 1) +
+                        temperature(i + 1, j) ) / 4 + bruit);
+                    ctc_t delta_temp = conduct *
+                        (nouvelle_temp - ancienne_temp);
+
+                    ctc(i, j).temperature += delta_temp;
+                    somme_rangee += std::abs(delta_temp);
+                    if (Stats)
+                        locales.inclure(temperature(i, j), delta_temp);
+                }
+#else
+                // Pointeurs vers les rangées voisines, sans vérification
+                const CTC * dessus = data() + (i - 1) * larg;
+                CTC * centre = data() + i * larg;
+                const CTC * dessous = data() + (i + 1) * larg;
+
+                for (std::size_t j = 1 + depart; j < larg - 1; j += 2) {
+                    ctc_t conduct = centre[j].conduction;
+                    ctc_t ancienne_temp = centre[j].temperature;
+                    ctc_t nouvelle_temp = std::max(centre[j].chaleur, (
+                        dessus[j].temperature +
+                        centre[j - 1].temperature +
+                        centre[j + 1].temperature +
+                        dessous[j].temperature ) / 4 + bruit);
+                    ctc_t delta_temp = conduct *
+                        (nouvelle_temp - ancienne_temp);
+
+                    centre[j].temperature += delta_temp;
+                    somme_rangee += std::abs(delta_temp);
+                    if (Stats)
+                        locales.inclure(centre[j].temperature, delta_temp);
+                }
+#endif
+                somme_delta.ajouter(somme_rangee);
+            }
+        }
+
+        if (Stats)
+            stats->fusionner(locales);
+
+        return somme_delta.valeur() / (larg * haut);
+    }
+};
+
+
+/**
+ * Référence vers un triplet CTC dont les composantes sont rangées
+ * dans des plans séparés
+ */
+class RefCTC
+{
+public:
+    RefCTC(ctc_t & ch, ctc_t & te, ctc_t & co):
+        chaleur(ch), temperature(te), conduction(co) {}
+
+    operator CTC() const { return CTC {chaleur, temperature, conduction}; }
+
+    const RefCTC & operator=(const CTC & ctc) const {
+        chaleur = ctc.chaleur;
+        temperature = ctc.temperature;
+        conduction = ctc.conduction;
+        return *this;
+    }
+    const RefCTC & operator=(const RefCTC & autre) const {
+        return *this = CTC(autre);
+    }
+
+    ctc_t & chaleur;
+    ctc_t & temperature;
+    ctc_t & conduction;
+};
+
+
+/**
+ * Itérateur séquentiel sur les triplets CTC d'un modèle en plans séparés.
+ * Permet d'utiliser std::transform et std::minmax_element comme avec
+ * ModeleCTC, même si aucun objet CTC n'existe en mémoire.
+ */
+template <class Modele, class Reference>
+class IterateurCTC
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef CTC value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Reference reference;
+
+    /**
+     * Pointeur vers une copie du triplet, pour l'opérateur ->
+     */
+    class pointer
+    {
+    public:
+        pointer(const CTC & ctc): copie(ctc) {}
+        const CTC * operator->() const { return &copie; }
+
+    private:
+        CTC copie;
+    };
+
+    IterateurCTC(): modele(NULL), k(0) {}
+    IterateurCTC(Modele * m, std::size_t indice): modele(m), k(indice) {}
+
+    inline reference operator*() const { return (*modele)[k]; }
+    inline pointer operator->() const { return pointer(CTC(**this)); }
+
+    inline IterateurCTC & operator++() { ++k; return *this; }
+    inline IterateurCTC operator++(int) {
+        IterateurCTC copie(*this);
+        ++k;
+        return copie;
+    }
+
+    inline bool operator==(const IterateurCTC & autre) const {
+        return k == autre.k;
+    }
+    inline bool operator!=(const IterateurCTC & autre) const {
+        return k != autre.k;
+    }
+
+private:
+    Modele * modele;
+    std::size_t k;
+};
+
+
+/**
+ * Itération d'écoulement de chaleur sur trois plans contigus, en damier
+ * (une couleur à la fois), la marge de 1 pixel restant fixe
+ * @param chal Plan de chaleur
+ * @param cond Plan de conduction
+ * @param temp Plan de température, mis à jour
+ * @param larg Largeur de la grille
+ * @param haut Hauteur de la grille
+ * @param bruit Bruit ajouté à la moyenne des températures voisines
+ * @param stats Statistiques à compléter si Stats, marge comprise
+ * @tparam Stats Vrai pour accumuler aussi les statistiques de l'itération
+ * @return La différence de température moyenne
+ */
+template <bool Stats = false>
+inline ctc_t pas_de_temps_plans(const ctc_t * chal, const ctc_t * cond,
+                                ctc_t * temp, std::size_t larg,
+                                std::size_t haut, ctc_t bruit,
+                                StatistiquesPas * stats = NULL)
+{
+    StatistiquesPas locales;
+    SommeCompensee somme_delta;
+
+    if (Stats) {
+        for (std::size_t j = 0; j < larg; ++j) {
+            locales.inclure(temp[j]);
+            locales.inclure(temp[(haut - 1) * larg + j]);
+        }
+        for (std::size_t i = 1; i < haut - 1; ++i) {
+            locales.inclure(temp[i * larg]);
+            locales.inclure(temp[i * larg + larg - 1]);
+        }
+    }
+
+    for (auto impair = 0; impair < 2; ++impair) {
+        for (std::size_t i = 1; i < haut - 1; ++i) {
+            auto depart = (((i + 1) ^ impair) & 1);  // Damier
+            const std::size_t rangee = i * larg;
+            ctc_t somme_rangee = 0.;
+
+            for (auto j = rangee + 1 + depart; j < rangee + larg - 1; j += 2) {
+                ctc_t conduct = cond[j];
+                ctc_t ancienne_temp = temp[j];
+                ctc_t nouvelle_temp = std::max(chal[j], (
+                    temp[j - larg] +
+                    temp[j - 1] +
+                    temp[j + 1] +
+                    temp[j + larg] ) / 4 + bruit);
+                ctc_t delta_temp = conduct *
+                    (nouvelle_temp - ancienne_temp);
+
+                temp[j] += delta_temp;
+                somme_rangee += std::abs(delta_temp);
+                if (Stats)
+                    locales.inclure(temp[j], delta_temp);
+            }
+
+            somme_delta.ajouter(somme_rangee);
+        }
+    }
+
+    if (Stats)
+        stats->fusionner(locales);
+
+    return somme_delta.valeur() / (larg * haut);
+}
+
+
+/**
+ * Modèle de grille 2D en structure de plans (Structure of Arrays) :
+ * les valeurs de chaleur, de température et de conduction sont rangées
+ * dans trois plans contigus. Les lectures des températures voisines
+ * n'amènent ainsi que des températures en cache.
+ */
+class ModeleCTCPlans
+{
+public:
+    typedef IterateurCTC<ModeleCTCPlans, RefCTC> iterator;
+    typedef IterateurCTC<const ModeleCTCPlans, CTC> const_iterator;
+
+    ModeleCTCPlans(): larg(0), haut(0), capacite(0), bruit(BRUIT) {}
+
+    /**
+     * Appliquer les paramètres d'exécution au modèle
+     */
+    void configurer(const Configuration & config) {
+        bruit = config.bruit;
+    }
+
+    /**
+     * Redimensionner la grille
+     */
+    void redimensionner(std::size_t largeur, std::size_t hauteur) {
+        larg = largeur;
+        haut = hauteur;
+
+        // Une grille plus petite réutilise les plans déjà alloués
+        if (larg * haut > capacite) {
+            capacite = larg * haut;
+            plan_chaleur.resize(capacite);
+            plan_temperature.resize(capacite);
+            plan_conduction.resize(capacite);
+        }
+    }
+
+    /**
+     * Copier des plans complets de largeur x hauteur valeurs dans la
+     * grille déjà dimensionnée, un plan à la fois
+     */
+    void copier_plans(const ctc_t * chaleur, const ctc_t * temperature,
+                      const ctc_t * conduction) {
+        const std::size_t n = larg * haut;
+
+        std::memcpy(plan_chaleur.data(), chaleur, n * sizeof(ctc_t));
+        std::memcpy(plan_temperature.data(), temperature, n * sizeof(ctc_t));
+        std::memcpy(plan_conduction.data(), conduction, n * sizeof(ctc_t));
+    }
+
+    /**
+     * Accès à un triplet (Chaleur, Température, Conduction)
+     */
+    inline RefCTC operator[](std::size_t k) {
+        return RefCTC(element(plan_chaleur, k),
+            element(plan_temperature, k), element(plan_conduction, k));
+    }
+    inline CTC operator[](std::size_t k) const {
+        return CTC {element(plan_chaleur, k),
+            element(plan_temperature, k), element(plan_conduction, k)};
+    }
+    inline RefCTC ctc(std::size_t rangee, std::size_t colonne) {
+        return (*this)[rangee * larg + colonne];
+    }
+    inline CTC ctc(std::size_t rangee, std::size_t colonne) const {
+        return (*this)[rangee * larg + colonne];
+    }
+
+    /**
+     * Accès à une composante
+     */
+    inline ctc_t chaleur(std::size_t rangee, std::size_t colonne) const {
+        return element(plan_chaleur, rangee * larg + colonne);
+    }
+    inline ctc_t temperature(std::size_t rangee, std::size_t colonne) const {
+        return element(plan_temperature, rangee * larg + colonne);
+    }
+    inline ctc_t conduction(std::size_t rangee, std::size_t colonne) const {
+        return element(plan_conduction, rangee * larg + colonne);
+    }
+
+    inline std::size_t largeur() const { return larg; }
+    inline std::size_t hauteur() const { return haut; }
+
+    inline iterator begin() { return iterator(this, 0); }
+    inline iterator end() { return iterator(this, larg * haut); }
+    inline const_iterator cbegin() const { return const_iterator(this, 0); }
+    inline const_iterator cend() const {
+        return const_iterator(this, larg * haut);
+    }
+
+    /**
+     * Effectuer une itération d'écoulement de chaleur sur toute la grille
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps() {
+#ifdef DEBUG
+        SommeCompensee somme_delta;
+
+        // Converge plus vite si on traite en damier (une couleur à la fois)
+        for (auto impair = 0; impair < 2; ++impair) {
+            // Laisser faire la marge de 1 pixel
+            for (std::size_t i = 1; i < haut - 1; ++i) {
+                auto depart = (((i + 1) ^ impair) & 1);  // Damier
+                ctc_t somme_rangee = 0.;
+
+                for (std::size_t j = 1 + depart; j < larg - 1; j += 2) {
+                    ctc_t conduct = conduction(i, j);
+                    ctc_t ancienne_temp = temperature(i, j);
+                    ctc_t nouvelle_temp = std::max(chaleur(i, j), (
+                        temperature(i - 1, j) +
+                        temperature(i, j - 1) +
+                        temperature(i, j + 1) +
+                        temperature(i + 1, j) ) / 4 + bruit);
+                    ctc_t delta_temp = conduct *
+                        (nouvelle_temp - ancienne_temp);
+
+                    ctc(i, j).temperature += delta_temp;
+                    somme_rangee += std::abs(delta_temp);
+                }
+
+                somme_delta.ajouter(somme_rangee);
+            }
+        }
+
+        return somme_delta.valeur() / (larg * haut);
+#else
+        // Pointeurs vers les plans, sans vérification
+        return pas_de_temps_plans(plan_chaleur.data(), plan_conduction.data(),
+                                  plan_temperature.data(), larg, haut, bruit);
+#endif
+    }
+
+    /**
+     * Effectuer une itération en accumulant ses statistiques
+     * @param stats Statistiques à compléter
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps(StatistiquesPas & stats) {
+        return pas_de_temps_plans<true>(plan_chaleur.data(),
+            plan_conduction.data(), plan_temperature.data(), larg, haut,
+            bruit, &stats);
+    }
+
+protected:
+    std::size_t larg;
+    std::size_t haut;
+    std::size_t capacite;  // Points alloués dans chaque plan
+
+    VecteurGrille<ctc_t> plan_chaleur;
+    VecteurGrille<ctc_t> plan_temperature;
+    VecteurGrille<ctc_t> plan_conduction;
+
+    ctc_t bruit;  // Bruit ajouté à la moyenne des températures voisines
+};
+
+
+/**
+ * Modèle en plans posé sur trois plans fournis par l'appelant, sans copie
+ * ni allocation : mêmes calculs que ModeleCTCPlans. L'appelant garde la
+ * propriété des plans, qui doivent vivre plus longtemps que la vue, et y
+ * lit directement les températures mises à jour.
+ */
+class ModeleCTCVue
+{
+public:
+    typedef IterateurCTC<ModeleCTCVue, RefCTC> iterator;
+    typedef IterateurCTC<const ModeleCTCVue, CTC> const_iterator;
+
+    /**
+     * @param chaleur Plan de chaleur, largeur x hauteur valeurs
+     * @param temperature Plan de température, mis à jour par le calcul
+     * @param conduction Plan de conduction
+     * @param largeur Largeur de la grille
+     * @param hauteur Hauteur de la grille
+     */
+    ModeleCTCVue(ctc_t * chaleur, ctc_t * temperature, ctc_t * conduction,
+                 std::size_t largeur, std::size_t hauteur):
+        larg(largeur), haut(hauteur), plan_chaleur(chaleur),
+        plan_temperature(temperature), plan_conduction(conduction),
+        bruit(BRUIT) {}
+
+    /**
+     * Appliquer les paramètres d'exécution au modèle
+     */
+    void configurer(const Configuration & config) {
+        bruit = config.bruit;
+    }
+
+    /**
+     * Accès à un triplet (Chaleur, Température, Conduction)
+     */
+    inline RefCTC operator[](std::size_t k) {
+        return RefCTC(plan_chaleur[k], plan_temperature[k],
+                      plan_conduction[k]);
+    }
+    inline CTC operator[](std::size_t k) const {
+        return CTC {plan_chaleur[k], plan_temperature[k], plan_conduction[k]};
+    }
+    inline RefCTC ctc(std::size_t rangee, std::size_t colonne) {
+        return (*this)[rangee * larg + colonne];
+    }
+    inline CTC ctc(std::size_t rangee, std::size_t colonne) const {
+        return (*this)[rangee * larg + colonne];
+    }
+
+    /**
+     * Accès à une composante
+     */
+    inline ctc_t chaleur(std::size_t rangee, std::size_t colonne) const {
+        return plan_chaleur[rangee * larg + colonne];
+    }
+    inline ctc_t temperature(std::size_t rangee, std::size_t colonne) const {
+        return plan_temperature[rangee * larg + colonne];
+    }
+    inline ctc_t conduction(std::size_t rangee, std::size_t colonne) const {
+        return plan_conduction[rangee * larg + colonne];
+    }
+
+    inline std::size_t largeur() const { return larg; }
+    inline std::size_t hauteur() const { return haut; }
+
+    inline iterator begin() { return iterator(this, 0); }
+    inline iterator end() { return iterator(this, larg * haut); }
+    inline const_iterator cbegin() const { return const_iterator(this, 0); }
+    inline const_iterator cend() const {
+        return const_iterator(this, larg * haut);
+    }
+
+    /**
+     * Effectuer une itération d'écoulement de chaleur sur toute la grille
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps() {
+        return pas_de_temps_plans(plan_chaleur, plan_conduction,
+                                  plan_temperature, larg, haut, bruit);
+    }
+
+    /**
+     * Effectuer une itération en accumulant ses statistiques
+     * @param stats Statistiques à compléter
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps(StatistiquesPas & stats) {
+        return pas_de_temps_plans<true>(plan_chaleur, plan_conduction,
+            plan_temperature, larg, haut, bruit, &stats);
+    }
+
+private:
+    std::size_t larg;
+    std::size_t haut;
+
+    ctc_t * plan_chaleur;
+    ctc_t * plan_temperature;
+    ctc_t * plan_conduction;
+
+    ctc_t bruit;  // Bruit ajouté à la moyenne des températures voisines
+};
+
+
+/**
+ * Température stockée en demi-précision IEEE (binary16) : 5 bits
+ * d'exposant et 10 bits de mantisse, convertie en ctc_t pour les calculs.
+ * Les conversions calculent tous les cas puis choisissent le bon, sans
+ * branche, pour que les boucles de conversion des rangées se vectorisent.
+ * L'arrondi est au plus proche pair.
+ */
+struct Demi {
+    Demi(): bits(0) {}
+    explicit Demi(float f) {
+        const std::uint32_t magique_bits = ((127 - 15) + (23 - 10) + 1) << 23;
+        std::uint32_t x, denormal;
+        float d, magique;
+
+        std::memcpy(&x, &f, sizeof x);
+        const std::uint32_t signe = x & 0x80000000u;
+        x ^= signe;
+
+        // Nombre dénormalisé en binary16, arrondi par l'addition
+        std::memcpy(&d, &x, sizeof d);
+        std::memcpy(&magique, &magique_bits, sizeof magique);
+        d += magique;
+        std::memcpy(&denormal, &d, sizeof denormal);
+        denormal -= magique_bits;
+
+        // Nombre normal : réajuster l'exposant (127 - 15) et arrondir
+        const std::uint32_t normal =
+            (x - (112u << 23) + 0xfff + ((x >> 13) & 1)) >> 13;
+
+        // Infini ou NaN au-delà du plus grand binary16
+        const std::uint32_t infini = x > (255u << 23) ? 0x7e00 : 0x7c00;
+
+        bits = (x >= (143u << 23) ? infini :
+                x < (113u << 23) ? denormal : normal) | (signe >> 16);
+    }
+
+    operator float() const {
+        const std::uint32_t exp_decale = 0x7c00 << 13;
+        const std::uint32_t magique_bits = 113u << 23;
+        const std::uint32_t x = ((bits & 0x7fff) << 13) + (112u << 23);
+        const std::uint32_t exposant = exp_decale & (bits << 13);
+        std::uint32_t denormal;
+        float f, magique;
+
+        // Dénormalisé : renormaliser par une soustraction
+        denormal = x + (1u << 23);
+        std::memcpy(&f, &denormal, sizeof f);
+        std::memcpy(&magique, &magique_bits, sizeof magique);
+        f -= magique;
+        std::memcpy(&denormal, &f, sizeof denormal);
+
+        std::uint32_t resultat = exposant == exp_decale ? x + (112u << 23) :
+            exposant == 0 ? denormal : x;
+        resultat |= std::uint32_t(bits & 0x8000) << 16;
+
+        std::memcpy(&f, &resultat, sizeof f);
+        return f;
+    }
+
+    std::uint16_t bits;
+};
+
+/**
+ * Température stockée en bfloat16 : les 16 bits de poids fort d'un float,
+ * avec le même exposant mais 7 bits de mantisse, arrondi au plus proche pair
+ */
+struct BFloat16 {
+    BFloat16(): bits(0) {}
+    explicit BFloat16(float f) {
+        std::uint32_t x;
+
+        std::memcpy(&x, &f, sizeof x);
+        bits = (x + 0x7fff + ((x >> 16) & 1)) >> 16;
+    }
+
+    operator float() const {
+        const std::uint32_t x = std::uint32_t(bits) << 16;
+        float f;
+
+        std::memcpy(&f, &x, sizeof f);
+        return f;
+    }
+
+    std::uint16_t bits;
+};
+
+
+/**
+ * Bits de mantisse d'un float que le stockage ne garde pas
+ */
+template <class Stockage>
+struct MantissePerdue { static const unsigned int BITS = 0; };
+template <>
+struct MantissePerdue<Demi> { static const unsigned int BITS = 23 - 10; };
+template <>
+struct MantissePerdue<BFloat16> { static const unsigned int BITS = 23 - 7; };
+
+/**
+ * Itérations entre deux mesures de la variation d'un stockage arrondi de
+ * façon stochastique : le bruit de l'arrondi, de l'ordre de l'écart entre
+ * deux valeurs représentables, y est divisé. L'écart de bfloat16 est 8 fois
+ * celui de demi-précision, sa fenêtre aussi.
+ */
+template <class Stockage>
+struct FenetreVariation { static const unsigned int PAS = 1; };
+template <>
+struct FenetreVariation<Demi> { static const unsigned int PAS = 64; };
+template <>
+struct FenetreVariation<BFloat16> { static const unsigned int PAS = 512; };
+
+/**
+ * Mélanger un compteur en 32 bits pseudo-aléatoires (lowbias32)
+ */
+inline std::uint32_t melanger(std::uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * Arrondi stochastique d'une rangée de températures à leur stockage : les
+ * bits de mantisse perdus sont arrondis vers le haut avec une probabilité
+ * égale à leur fraction. Une variation plus petite que l'écart entre deux
+ * valeurs représentables est ainsi gardée en moyenne, au lieu d'être
+ * toujours effacée par l'arrondi au plus proche. Les valeurs obtenues sont
+ * exactes dans le stockage, hors nombres dénormalisés, et une valeur qui
+ * l'était déjà est inchangée. Les tirages d'une rangée suivent une suite
+ * de Weyl (pas du nombre d'or), équirépartie, depuis une origine mélangée
+ * pour elle seule : une addition par point, et la boucle se vectorise.
+ * @param rangee Températures arrondies en place
+ * @param n Nombre de températures
+ * @param graine Numéro du tirage de la rangée
+ */
+template <class Stockage>
+inline void arrondir_rangee(ctc_t * rangee, std::size_t n,
+                            std::uint32_t graine)
+{
+    const std::uint32_t masque = (1u << MantissePerdue<Stockage>::BITS) - 1;
+    std::uint32_t tirage = melanger(graine);
+
+    for (std::size_t j = 0; j < n; ++j, tirage += 0x9e3779b9u) {
+        float f = (float)rangee[j];
+        std::uint32_t bits;
+
+        std::memcpy(&bits, &f, sizeof bits);
+        bits = (bits + ((tirage >> 16) & masque)) & ~masque;
+        std::memcpy(&f, &bits, sizeof f);
+        rangee[j] = f;
+    }
+}
+
+
+/**
+ * Écart entre deux valeurs représentables du stockage autour d'une
+ * température positive : sa puissance de 2, réduite aux bits de mantisse
+ * que le stockage garde
+ */
+template <class Stockage>
+inline ctc_t ecart_representable(ctc_t temp)
+{
+    const float echelle = 1.f / (1u << (23 - MantissePerdue<Stockage>::BITS));
+    float f = (float)temp;
+    std::uint32_t bits;
+
+    std::memcpy(&bits, &f, sizeof bits);
+    bits &= 0x7f800000u;  // Exposant seul
+    std::memcpy(&f, &bits, sizeof f);
+    return f * echelle;
+}
+
+
+/**
+ * Convertir une rangée de températures stockées en ctc_t, et inversement
+ */
+template <class Stockage>
+inline void dilater_rangee(const Stockage * source, ctc_t * dest,
+                           std::size_t n)
+{
+    for (std::size_t j = 0; j < n; ++j)
+        dest[j] = (float)source[j];
+}
+
+template <class Stockage>
+inline void compacter_rangee(const ctc_t * source, Stockage * dest,
+                             std::size_t n)
+{
+    for (std::size_t j = 0; j < n; ++j)
+        dest[j] = Stockage((float)source[j]);
+}
+
+
+#ifdef CTC_AVX
+/**
+ * Conversions de demi-précision par les instructions F16C, 8 valeurs à la
+ * fois, choisies à l'exécution comme les noyaux SIMD du damier
+ */
+__attribute__((target("avx,f16c")))
+inline void dilater_rangee_f16c(const Demi * source, float * dest,
+                                std::size_t n)
+{
+    std::size_t j = 0;
+
+    for (; j + 8 <= n; j += 8) {
+        const __m128i demi = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(source + j));
+        _mm256_storeu_ps(dest + j, _mm256_cvtph_ps(demi));
+    }
+    for (; j < n; ++j)
+        dest[j] = source[j];
+}
+
+__attribute__((target("avx,f16c")))
+inline void compacter_rangee_f16c(const float * source, Demi * dest,
+                                  std::size_t n)
+{
+    std::size_t j = 0;
+
+    for (; j + 8 <= n; j += 8) {
+        const __m128i demi = _mm256_cvtps_ph(_mm256_loadu_ps(source + j),
+            _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + j), demi);
+    }
+    for (; j < n; ++j)
+        dest[j] = Demi(source[j]);
+}
+
+inline bool processeur_f16c()
+{
+    static const bool f16c = (__builtin_cpu_init(),
+        __builtin_cpu_supports("f16c"));
+    return f16c;
+}
+
+template <>
+inline void dilater_rangee(const Demi * source, ctc_t * dest, std::size_t n)
+{
+    if (processeur_f16c()) {
+        dilater_rangee_f16c(source, dest, n);
+        return;
+    }
+
+    for (std::size_t j = 0; j < n; ++j)
+        dest[j] = source[j];
+}
+
+template <>
+inline void compacter_rangee(const ctc_t * source, Demi * dest, std::size_t n)
+{
+    if (processeur_f16c()) {
+        compacter_rangee_f16c(source, dest, n);
+        return;
+    }
+
+    for (std::size_t j = 0; j < n; ++j)
+        dest[j] = Demi(source[j]);
+}
+#endif
+
+
+/**
+ * Référence vers un triplet CTC d'un modèle compact : la chaleur et la
+ * conduction sont des canaux de 8 bits, et la température est stockée
+ * selon le type Stockage
+ */
+template <class Stockage>
+class RefCTCCompact
+{
+public:
+    RefCTCCompact(std::uint8_t & ch, Stockage & te, std::uint8_t & co):
+        chaleur(ch), temperature(te), conduction(co) {}
+
+    operator CTC() const {
+        return CTC {
+            (ctc_t)chaleur, (ctc_t)(float)temperature,
+            (ctc_t)conduction / 256
+        };
+    }
+
+    const RefCTCCompact & operator=(const CTC & ctc) const {
+        chaleur = (std::uint8_t)ctc.chaleur;
+        temperature = Stockage((float)ctc.temperature);
+        conduction = (std::uint8_t)(ctc.conduction * 256);
+        return *this;
+    }
+    const RefCTCCompact & operator=(const RefCTCCompact & autre) const {
+        return *this = CTC(autre);
+    }
+
+    std::uint8_t & chaleur;
+    Stockage & temperature;
+    std::uint8_t & conduction;
+};
+
+
+/**
+ * Modèle de grille 2D en plans compacts pour réduire le trafic mémoire.
+ * La chaleur et la conduction viennent de canaux PNG de 8 bits : elles sont
+ * gardées telles quelles (uint8_t) et converties dans les registres, la
+ * conduction étant le canal bleu divisé par 256. La température est
+ * stockée selon le type Stockage (float, Demi ou BFloat16), mais tous les
+ * calculs et la somme des variations se font en ctc_t. Un point occupe
+ * ainsi 6 octets au lieu de 12 en float, ou 4 en demi-précision et en
+ * bfloat16, plus 2 octets de référence qui ne sont lus et écrits qu'une
+ * fois par fenêtre de mesure.
+ *
+ * Avec Stockage = float, les températures sont identiques au modèle en
+ * plans. En 16 bits, l'arrondi au plus proche effacerait toute variation
+ * plus petite que la moitié de l'écart entre deux valeurs représentables,
+ * qui vaut 0.125 juste sous 256 en demi-précision et 1 en bfloat16 : la
+ * grille se figerait loin de son point fixe. Les rangées sont donc
+ * réécrites avec un arrondi stochastique : les températures avancent en
+ * moyenne comme en float, mais gardent autour du point fixe un bruit de
+ * l'ordre de cet écart. D'une itération à l'autre, ce bruit tiendrait
+ * l'ajustement bien au-dessus du seuil de convergence. La variation
+ * mesurée est donc celle des températures stockées depuis une référence
+ * prise FenetreVariation<Stockage>::PAS itérations plus tôt, ramenée à
+ * une itération : le bruit y est divisé par autant, la progression vers le
+ * point fixe non. Le seuil de convergence est en plus relevé au bruit qui
+ * reste (seuil_arret()).
+ */
+template <class Stockage>
+class ModeleCTCCompact
+{
+public:
+    typedef IterateurCTC<ModeleCTCCompact, RefCTCCompact<Stockage> > iterator;
+    typedef IterateurCTC<const ModeleCTCCompact, CTC> const_iterator;
+
+    ModeleCTCCompact(): larg(0), haut(0), bruit(BRUIT), graine(0),
+        nb_pas_fenetre(0), reference_prise(false), fenetre_mesuree(false),
+        variation_moyenne(0.), variation_max(0.), resolution_moyenne(0.),
+        resolution_max(0.) {}
+
+    /**
+     * Appliquer les paramètres d'exécution au modèle
+     */
+    void configurer(const Configuration & config) {
+        bruit = config.bruit;
+    }
+
+    /**
+     * Redimensionner la grille
+     */
+    void redimensionner(std::size_t largeur, std::size_t hauteur) {
+        larg = largeur;
+        haut = hauteur;
+
+        plan_chaleur.resize(larg * haut);
+        plan_temperature.resize(larg * haut);
+        plan_conduction.resize(larg * haut);
+        if (!direct)
+            plan_reference.resize(larg * haut);
+
+        reference_prise = fenetre_mesuree = false;
+    }
+
+    /**
+     * Accès à un triplet (Chaleur, Température, Conduction)
+     */
+    inline RefCTCCompact<Stockage> operator[](std::size_t k) {
+        return RefCTCCompact<Stockage>(element(plan_chaleur, k),
+            element(plan_temperature, k), element(plan_conduction, k));
+    }
+    inline CTC operator[](std::size_t k) const {
+        return CTC {
+            (ctc_t)element(plan_chaleur, k),
+            (ctc_t)(float)element(plan_temperature, k),
+            (ctc_t)element(plan_conduction, k) / 256
+        };
+    }
+    inline RefCTCCompact<Stockage> ctc(std::size_t rangee,
+                                       std::size_t colonne) {
+        return (*this)[rangee * larg + colonne];
+    }
+    inline CTC ctc(std::size_t rangee, std::size_t colonne) const {
+        return (*this)[rangee * larg + colonne];
+    }
+
+    /**
+     * Accès à une composante
+     */
+    inline ctc_t chaleur(std::size_t rangee, std::size_t colonne) const {
+        return ctc(rangee, colonne).chaleur;
+    }
+    inline ctc_t temperature(std::size_t rangee, std::size_t colonne) const {
+        return ctc(rangee, colonne).temperature;
+    }
+    inline ctc_t conduction(std::size_t rangee, std::size_t colonne) const {
+        return ctc(rangee, colonne).conduction;
+    }
+
+    inline std::size_t largeur() const { return larg; }
+    inline std::size_t hauteur() const { return haut; }
+
+    inline iterator begin() { return iterator(this, 0); }
+    inline iterator end() { return iterator(this, larg * haut); }
+    inline const_iterator cbegin() const { return const_iterator(this, 0); }
+    inline const_iterator cend() const {
+        return const_iterator(this, larg * haut);
+    }
+
+    /**
+     * Effectuer une itération d'écoulement de chaleur sur toute la grille.
+     * La chaleur et la conduction de chaque rangée sont d'abord converties
+     * dans des tampons en ctc_t, par des boucles contiguës qui se
+     * vectorisent. Si la température n'est pas stockée en ctc_t, les
+     * rangées du front le sont aussi, dans un anneau de tampons : chaque
+     * rangée n'est convertie qu'une fois par itération, puis réécrite après
+     * sa mise à jour.
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps() {
+        return balayer<false>(NULL);
+    }
+
+    /**
+     * Effectuer une itération en accumulant ses statistiques
+     * @param stats Statistiques à compléter
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps(StatistiquesPas & stats) {
+        inclure_marge(*this, stats);
+        return balayer<true>(&stats);
+    }
+
+    /**
+     * Variation par itération que l'arrondi stochastique entretient encore
+     * au point fixe, selon les températures de la dernière fenêtre
+     * mesurée : 0 si elles sont stockées en ctc_t.
+     * @param critere Mesure de la variation
+     */
+    ctc_t bruit_arrondi(CritereConvergence critere) const {
+        // Au point fixe, la variation d'une itération reste près du tiers
+        // de la résolution moyenne, et la plus grande atteint deux écarts :
+        // une fenêtre les divise par son nombre d'itérations
+        return (critere == CRITERE_MAX ? 4 * resolution_max :
+            resolution_moyenne) / FenetreVariation<Stockage>::PAS;
+    }
+
+private:
+    std::size_t larg;
+    std::size_t haut;
+
+    VecteurGrille<std::uint8_t> plan_chaleur;
+    VecteurGrille<Stockage> plan_temperature;
+    VecteurGrille<std::uint8_t> plan_conduction;
+    VecteurGrille<Stockage> plan_reference;  // Températures au début de la
+                                             // fenêtre, en 16 bits
+
+    // Température stockée en ctc_t, calculée en place
+    static const bool direct = std::is_same<Stockage, ctc_t>::value;
+
+    std::vector<ctc_t> tampons;  // Rangées converties en ctc_t
+    ctc_t bruit;  // Bruit ajouté à la moyenne des températures voisines
+    std::uint32_t graine;  // Compteur des tirages de l'arrondi stochastique
+
+    unsigned int nb_pas_fenetre;  // Itérations depuis la référence
+    bool reference_prise;   // Faux avant la première itération
+    bool fenetre_mesuree;   // Vrai après la première fenêtre complète
+    ctc_t variation_moyenne;   // Par point et par itération, sur la
+                               // dernière fenêtre
+    ctc_t variation_max;       // D'un point, par itération, sur la
+                               // dernière fenêtre
+    ctc_t resolution_moyenne;  // Conduction fois écart représentable, par
+                               // point, à la fin de la dernière fenêtre
+    ctc_t resolution_max;  // Plus grand écart représentable d'un point
+                           // conducteur, à la fin de la dernière fenêtre
+
+    /**
+     * Mesure des variations d'un balayage en 16 bits : depuis la référence
+     * à la fin d'une fenêtre, depuis l'itération précédente tant qu'aucune
+     * fenêtre n'est complète, et aucune autrement
+     */
+    struct MesureFront {
+        MesureFront(bool fin, bool prise, bool variations):
+            delta_max(0.), resolution_max(0.), fin_fenetre(fin),
+            prendre_reference(prise), mesurer(variations) {}
+
+        SommeCompensee somme_delta;
+        ctc_t delta_max;
+        SommeCompensee somme_resolution;  // Seulement à la fin d'une fenêtre
+        ctc_t resolution_max;
+        bool fin_fenetre;        // Comparer à la référence
+        bool prendre_reference;  // Copier les rangées dans la référence
+        bool mesurer;            // Mesurer les variations
+    };
+
+    /**
+     * Balayer la grille en damier, par rangées converties en ctc_t.
+     * Stockées en ctc_t, les températures sont calculées en place, une
+     * couleur après l'autre. Sinon, les deux couleurs avancent en un seul
+     * front : la première couleur de la rangée i, puis la seconde de la
+     * rangée i - 1, dont tous les voisins sont alors à jour. Les mises à
+     * jour sont celles des deux passes, mais chaque rangée n'est convertie
+     * et réécrite qu'une fois par itération. Les variations et les
+     * extrêmes sont alors ceux des températures stockées, après leur
+     * arrondi stochastique : ceux que la grille reçoit réellement. Après la
+     * première fenêtre, les variations sont celles de la dernière fenêtre
+     * complète, par itération.
+     * @tparam Stats Vrai pour accumuler aussi les statistiques
+     * @param stats Statistiques à compléter si Stats
+     * @return La différence de température moyenne
+     */
+    template <bool Stats>
+    ctc_t balayer(StatistiquesPas * stats) {
+        StatistiquesPas locales;
+        ctc_t delta_temp = 0.;
+
+        if (direct) {
+            SommeCompensee somme_delta;
+
+            tampons.resize(2 * larg);
+            ctc_t * chal = tampons.data();
+            ctc_t * cond = chal + larg;
+
+            // Converge plus vite si on traite en damier (une couleur à la fois)
+            for (auto impair = 0; impair < 2; ++impair) {
+                // Laisser faire la marge de 1 pixel
+                for (std::size_t i = 1; i < haut - 1; ++i) {
+                    ctc_t * centre = reinterpret_cast<ctc_t *>(
+                        &element(plan_temperature, i * larg));
+
+                    convertir_conditions(i, chal, cond);
+                    somme_delta.ajouter(mettre_a_jour<Stats>(i, impair,
+                        chal, cond, centre - larg, centre, centre + larg,
+                        locales));
+                }
+            }
+            delta_temp = somme_delta.valeur() / (larg * haut);
+        }
+        else if (haut > 2) {
+            const unsigned int pas = FenetreVariation<Stockage>::PAS;
+            const bool fin = reference_prise && nb_pas_fenetre + 1 == pas;
+            MesureFront mesure(fin, !reference_prise || fin,
+                               fin || !fenetre_mesuree);
+
+            tampons.resize(9 * larg);
+            ctc_t * anneau[4];
+            ctc_t * chal[2];
+            ctc_t * cond[2];
+            ctc_t * anciennes = tampons.data() + 8 * larg;
+
+            for (auto k = 0; k < 4; ++k)
+                anneau[k] = tampons.data() + k * larg;
+            for (auto k = 0; k < 2; ++k) {
+                chal[k] = tampons.data() + (4 + 2 * k) * larg;
+                cond[k] = chal[k] + larg;
+            }
+
+            dilater(0, anneau[0]);
+            dilater(1, anneau[1]);
+
+            for (std::size_t i = 1; i < haut - 1; ++i) {
+                dilater(i + 1, anneau[(i + 1) % 4]);
+                convertir_conditions(i, chal[i & 1], cond[i & 1]);
+                mettre_a_jour<false>(i, 0, chal[i & 1], cond[i & 1],
+                    anneau[(i - 1) % 4], anneau[i % 4], anneau[(i + 1) % 4],
+                    locales);
+
+                if (i > 1)
+                    finir_rangee<Stats>(i - 1, anneau, chal, cond,
+                                        anciennes, mesure, locales);
+            }
+            finir_rangee<Stats>(haut - 2, anneau, chal, cond, anciennes,
+                                mesure, locales);
+
+            if (fin) {
+                variation_moyenne =
+                    mesure.somme_delta.valeur() / (larg * haut) / pas;
+                variation_max = mesure.delta_max / pas;
+                resolution_moyenne =
+                    mesure.somme_resolution.valeur() / (larg * haut);
+                resolution_max = mesure.resolution_max;
+                fenetre_mesuree = true;
+            }
+            nb_pas_fenetre = mesure.prendre_reference ? 0 : nb_pas_fenetre + 1;
+            reference_prise = true;
+
+            if (fenetre_mesuree) {
+                delta_temp = variation_moyenne;
+                locales.delta_max = variation_max;
+            }
+            else {
+                delta_temp = mesure.somme_delta.valeur() / (larg * haut);
+                locales.delta_max = mesure.delta_max;
+            }
+        }
+
+        if (Stats)
+            stats->fusionner(locales);
+
+        return delta_temp;
+    }
+
+    /**
+     * Mettre à jour la seconde couleur d'une rangée du front, puis la
+     * réécrire dans son stockage et en mesurer les variations
+     * @param anciennes Tampon d'une rangée, pour les températures stockées
+     *                  de comparaison
+     * @param mesure Variations du balayage à compléter
+     */
+    template <bool Stats>
+    void finir_rangee(std::size_t i, ctc_t * const anneau[4],
+                      ctc_t * const chal[2], ctc_t * const cond[2],
+                      ctc_t * anciennes, MesureFront & mesure,
+                      StatistiquesPas & locales) {
+        ctc_t * nouvelles = anneau[i % 4];
+        const ctc_t * conduction = cond[i & 1];
+        Stockage * reference = plan_reference.data() + i * larg;
+
+        mettre_a_jour<false>(i, 1, chal[i & 1], conduction,
+            anneau[(i - 1) % 4], nouvelles, anneau[(i + 1) % 4], locales);
+        if (mesure.fin_fenetre)
+            dilater_rangee(reference, anciennes, larg);
+        else if (mesure.mesurer)
+            dilater(i, anciennes);
+        compacter(nouvelles, i);
+        if (mesure.prendre_reference) {
+            std::copy_n(&element(plan_temperature, i * larg), larg,
+                        reference);
+        }
+
+        if (!mesure.mesurer) {
+            if (Stats) {
+                for (std::size_t j = 1; j < larg - 1; ++j)
+                    locales.inclure(nouvelles[j]);
+            }
+            return;
+        }
+
+        // Marge de gauche et de droite exclue, comme des mises à jour
+        ctc_t somme_rangee = 0., delta_max = mesure.delta_max;
+
+        for (std::size_t j = 1; j < larg - 1; ++j) {
+            const ctc_t delta_temp = std::abs(nouvelles[j] - anciennes[j]);
+
+            somme_rangee += delta_temp;
+            delta_max = std::max(delta_max, delta_temp);
+            if (Stats)
+                locales.inclure(nouvelles[j]);
+        }
+        mesure.somme_delta.ajouter(somme_rangee);
+        mesure.delta_max = delta_max;
+
+        if (mesure.fin_fenetre) {
+            ctc_t resolution_rangee = 0.;
+
+            for (std::size_t j = 1; j < larg - 1; ++j) {
+                const ctc_t ecart =
+                    ecart_representable<Stockage>(nouvelles[j]);
+
+                resolution_rangee += conduction[j] * ecart;
+                if (conduction[j] > 0)
+                    mesure.resolution_max =
+                        std::max(mesure.resolution_max, ecart);
+            }
+            mesure.somme_resolution.ajouter(resolution_rangee);
+        }
+    }
+
+    /**
+     * Mettre à jour une couleur d'une rangée convertie en ctc_t
+     * @param i Numéro de la rangée
+     * @param impair Couleur mise à jour
+     * @param chal Chaleur de la rangée
+     * @param cond Conduction de la rangée
+     * @param dessus Températures de la rangée précédente
+     * @param centre Températures de la rangée, mises à jour
+     * @param dessous Températures de la rangée suivante
+     * @param locales Statistiques à compléter si Stats
+     * @return La somme des variations de la rangée
+     */
+    template <bool Stats>
+    ctc_t mettre_a_jour(std::size_t i, int impair, const ctc_t * chal,
+                        const ctc_t * cond, const ctc_t * dessus,
+                        ctc_t * centre, const ctc_t * dessous,
+                        StatistiquesPas & locales) {
+        const std::size_t depart = (((i + 1) ^ impair) & 1);  // Damier
+        ctc_t somme_rangee = 0.;
+
+        for (std::size_t j = 1 + depart; j < larg - 1; j += 2) {
+            ctc_t conduct = cond[j];
+            ctc_t ancienne_temp = centre[j];
+            ctc_t nouvelle_temp = std::max(chal[j], (
+                dessus[j] +
+                centre[j - 1] +
+                centre[j + 1] +
+                dessous[j] ) / 4 + bruit);
+            ctc_t delta_temp = conduct * (nouvelle_temp - ancienne_temp);
+
+            centre[j] += delta_temp;
+            somme_rangee += std::abs(delta_temp);
+            if (Stats)
+                locales.inclure(centre[j], delta_temp);
+        }
+
+        return somme_rangee;
+    }
+
+    /**
+     * Convertir la chaleur et la conduction d'une rangée en ctc_t, par des
+     * boucles contiguës qui se vectorisent
+     */
+    void convertir_conditions(std::size_t rangee, ctc_t * chal,
+                              ctc_t * cond) const {
+        const std::uint8_t * chal8 = &element(plan_chaleur, rangee * larg);
+        const std::uint8_t * cond8 = &element(plan_conduction, rangee * larg);
+
+        for (std::size_t j = 0; j < larg; ++j) {
+            chal[j] = chal8[j];
+            cond[j] = (ctc_t)cond8[j] / 256;
+        }
+    }
+
+    /**
+     * Convertir les températures d'une rangée en ctc_t
+     */
+    void dilater(std::size_t rangee, ctc_t * tampon) const {
+        dilater_rangee(&element(plan_temperature, rangee * larg), tampon, larg);
+    }
+
+    /**
+     * Stocker les températures d'une rangée convertie, après leur arrondi
+     * stochastique en place : la conversion au stockage est alors exacte
+     */
+    void compacter(ctc_t * tampon, std::size_t rangee) {
+        arrondir_rangee<Stockage>(tampon, larg, graine++);
+        compacter_rangee(tampon, &element(plan_temperature, rangee * larg),
+            larg);
+    }
+};
+
+
+/**
+ * Rangée d'une couleur du damier à mettre à jour : pointeurs vers les plans
+ * compactés de la couleur traitée et vers les trois rangées de températures
+ * voisines de l'autre couleur
+ */
+template <class T>
+struct RangeeDamierT {
+    const T * chaleur;
+    const T * conduction;
+    T * temperature;
+    const T * dessus;
+    const T * centre;
+    const T * dessous;
+    std::size_t p;      // Parité de la colonne : j = 2k + p
+    std::size_t debut;  // Premier indice compacté à traiter
+    std::size_t fin;    // Indice compacté suivant le dernier à traiter
+    T bruit;            // Ajouté à la moyenne des voisins
+    T omega;            // Facteur de sur-relaxation (noyau SOR seulement)
+};
+
+typedef RangeeDamierT<ctc_t> RangeeDamier;
+
+/**
+ * Noyau de calcul d'une rangée du damier
+ * @param r Rangée à traiter
+ * @param somme_delta Somme des variations accumulée jusqu'ici
+ * @return La somme accumulée incluant les variations de la rangée
+ */
+typedef ctc_t (*NoyauDamier)(const RangeeDamier & r, ctc_t somme_delta);
+
+/**
+ * Spécialisations d'un même noyau, selon la parité p de la rangée (qui
+ * fixe le décalage des voisins de gauche et de droite) et selon que la
+ * chaleur y impose ou non un plancher à la température cible. Chacune
+ * est compilée en une boucle sans branche ni décalage variable.
+ */
+struct JeuNoyaux {
+    inline NoyauDamier choisir(std::size_t p, bool plancher) const {
+        return noyaux[p][plancher];
+    }
+
+    NoyauDamier noyaux[2][2];  // [p][plancher]
+};
+
+
+/**
+ * Noyau scalaire, de référence
+ * @tparam T Type des valeurs
+ * @tparam P Parité de la colonne des points de la rangée
+ * @tparam Plancher Vrai si la chaleur borne la température cible ; sinon,
+ *                  la chaleur de la rangée est nulle et n'est pas lue
+ */
+template <class T, std::size_t P, bool Plancher>
+T rangee_scalaire(const RangeeDamierT<T> & r, T somme_delta)
+{
+    const T bruit = r.bruit;
+
+    for (std::size_t k = r.debut; k < r.fin; ++k) {
+        T conduct = r.conduction[k];
+        T ancienne_temp = r.temperature[k];
+        T moyenne = (
+            r.dessus[k] +
+            r.centre[k - 1 + P] +
+            r.centre[k + P] +
+            r.dessous[k] ) / 4 + bruit;
+        T nouvelle_temp = Plancher ? std::max(r.chaleur[k], moyenne) :
+            moyenne;
+        T delta_temp = conduct * (nouvelle_temp - ancienne_temp);
+
+        r.temperature[k] += delta_temp;
+        somme_delta += std::abs(delta_temp);
+    }
+
+    return somme_delta;
+}
+
+const JeuNoyaux NOYAUX_SCALAIRES = {{
+    {rangee_scalaire<ctc_t, 0, false>, rangee_scalaire<ctc_t, 0, true>},
+    {rangee_scalaire<ctc_t, 1, false>, rangee_scalaire<ctc_t, 1, true>}
+}};
+
+
+/**
+ * Noyau de sur-relaxation successive (SOR) projetée. Le point fixe ne
+ * dépend pas de la conduction, sauf là où elle est nulle : chaque point
+ * conducteur fait donc un pas complet amplifié par omega plutôt qu'un pas
+ * réduit par sa conduction, et une conduction nulle reste sans effet.
+ * Le résultat est ensuite projeté pour ne pas descendre sous la chaleur,
+ * à moins que la température y soit déjà. Cette projection sert aussi
+ * sans chaleur : le noyau garde donc toujours son plancher.
+ */
+template <class T, std::size_t P>
+T rangee_sor(const RangeeDamierT<T> & r, T somme_delta)
+{
+    const T bruit = r.bruit;
+    const T omega = r.omega;
+
+    for (std::size_t k = r.debut; k < r.fin; ++k) {
+        T facteur = r.conduction[k] > 0 ? omega : 0;
+        T ancienne_temp = r.temperature[k];
+        T nouvelle_temp = std::max(r.chaleur[k], (
+            r.dessus[k] +
+            r.centre[k - 1 + P] +
+            r.centre[k + P] +
+            r.dessous[k] ) / 4 + bruit);
+        T temp_relaxee = std::max(
+            ancienne_temp + facteur * (nouvelle_temp - ancienne_temp),
+            std::min(ancienne_temp, r.chaleur[k]));
+        T delta_temp = temp_relaxee - ancienne_temp;
+
+        r.temperature[k] = temp_relaxee;
+        somme_delta += std::abs(delta_temp);
+    }
+
+    return somme_delta;
+}
+
+const JeuNoyaux NOYAUX_SOR = {{
+    {rangee_sor<ctc_t, 0>, rangee_sor<ctc_t, 0>},
+    {rangee_sor<ctc_t, 1>, rangee_sor<ctc_t, 1>}
+}};
+
+
+#ifdef CTC_AVX
+/**
+ * Noyau AVX2 : 8 points d'une même couleur par instruction.
+ * Les opérations sont les mêmes que le noyau scalaire (sans FMA),
+ * seul l'ordre de sommation des variations diffère.
+ */
+template <std::size_t P, bool Plancher>
+__attribute__((target("avx2")))
+ctc_t rangee_avx2(const RangeeDamier & r, ctc_t somme_delta)
+{
+    const __m256 quart = _mm256_set1_ps(0.25f);
+    const __m256 bruit = _mm256_set1_ps(r.bruit);
+    const __m256 signe = _mm256_set1_ps(-0.0f);
+    __m256 somme = _mm256_setzero_ps();
+    std::size_t k = r.debut;
+
+    for (; k + 8 <= r.fin; k += 8) {
+        const __m256 conduct = _mm256_loadu_ps(r.conduction + k);
+        const __m256 ancienne_temp = _mm256_loadu_ps(r.temperature + k);
+        const __m256 voisins = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_loadu_ps(r.dessus + k),
+            _mm256_loadu_ps(r.centre + k - 1 + P)),
+            _mm256_loadu_ps(r.centre + k + P)),
+            _mm256_loadu_ps(r.dessous + k));
+        const __m256 moyenne =
+            _mm256_add_ps(_mm256_mul_ps(voisins, quart), bruit);
+        const __m256 nouvelle_temp = Plancher ?
+            _mm256_max_ps(moyenne, _mm256_loadu_ps(r.chaleur + k)) : moyenne;
+        const __m256 delta_temp = _mm256_mul_ps(conduct,
+            _mm256_sub_ps(nouvelle_temp, ancienne_temp));
+
+        _mm256_storeu_ps(r.temperature + k,
+            _mm256_add_ps(ancienne_temp, delta_temp));
+        somme = _mm256_add_ps(somme, _mm256_andnot_ps(signe, delta_temp));
+    }
+
+    // Réduction horizontale : 8 -> 4 -> 2 -> 1
+    __m128 somme4 = _mm_add_ps(_mm256_castps256_ps128(somme),
+        _mm256_extractf128_ps(somme, 1));
+    __m128 somme2 = _mm_add_ps(somme4, _mm_movehl_ps(somme4, somme4));
+    __m128 somme1 = _mm_add_ss(somme2, _mm_movehdup_ps(somme2));
+    somme_delta += _mm_cvtss_f32(somme1);
+
+    // Derniers points de la rangée
+    RangeeDamier reste(r);
+    reste.debut = k;
+    return rangee_scalaire<ctc_t, P, Plancher>(reste, somme_delta);
+}
+
+
+/**
+ * Noyau AVX-512 : 16 points d'une même couleur par instruction,
+ * la fin de la rangée étant traitée avec un masque
+ */
+template <std::size_t P, bool Plancher>
+__attribute__((target("avx512f")))
+ctc_t rangee_avx512(const RangeeDamier & r, ctc_t somme_delta)
+{
+    const __m512 quart = _mm512_set1_ps(0.25f);
+    const __m512 bruit = _mm512_set1_ps(r.bruit);
+    __m512 somme = _mm512_setzero_ps();
+
+    for (std::size_t k = r.debut; k < r.fin; k += 16) {
+        const __mmask16 m = (r.fin - k >= 16) ?
+            (__mmask16)0xFFFF : (__mmask16)((1u << (r.fin - k)) - 1);
+
+        const __m512 conduct = _mm512_maskz_loadu_ps(m, r.conduction + k);
+        const __m512 ancienne_temp =
+            _mm512_maskz_loadu_ps(m, r.temperature + k);
+        const __m512 voisins = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(
+            _mm512_maskz_loadu_ps(m, r.dessus + k),
+            _mm512_maskz_loadu_ps(m, r.centre + k - 1 + P)),
+            _mm512_maskz_loadu_ps(m, r.centre + k + P)),
+            _mm512_maskz_loadu_ps(m, r.dessous + k));
+        const __m512 moyenne =
+            _mm512_add_ps(_mm512_mul_ps(voisins, quart), bruit);
+        const __m512 nouvelle_temp = Plancher ? _mm512_max_ps(moyenne,
+            _mm512_maskz_loadu_ps(m, r.chaleur + k)) : moyenne;
+        const __m512 delta_temp = _mm512_mul_ps(conduct,
+            _mm512_sub_ps(nouvelle_temp, ancienne_temp));
+
+        _mm512_mask_storeu_ps(r.temperature + k, m,
+            _mm512_add_ps(ancienne_temp, delta_temp));
+        somme = _mm512_add_ps(somme, _mm512_abs_ps(delta_temp));
+    }
+
+    return somme_delta + _mm512_reduce_add_ps(somme);
+}
+
+const JeuNoyaux NOYAUX_AVX2 = {{
+    {rangee_avx2<0, false>, rangee_avx2<0, true>},
+    {rangee_avx2<1, false>, rangee_avx2<1, true>}
+}};
+
+const JeuNoyaux NOYAUX_AVX512 = {{
+    {rangee_avx512<0, false>, rangee_avx512<0, true>},
+    {rangee_avx512<1, false>, rangee_avx512<1, true>}
+}};
+#endif
+
+
+#ifdef CTC_NEON
+/**
+ * Noyau NEON : 4 points d'une même couleur par instruction
+ */
+template <std::size_t P, bool Plancher>
+ctc_t rangee_neon(const RangeeDamier & r, ctc_t somme_delta)
+{
+    const float32x4_t quart = vdupq_n_f32(0.25f);
+    const float32x4_t bruit = vdupq_n_f32(r.bruit);
+    float32x4_t somme = vdupq_n_f32(0.f);
+    std::size_t k = r.debut;
+
+    for (; k + 4 <= r.fin; k += 4) {
+        const float32x4_t conduct = vld1q_f32(r.conduction + k);
+        const float32x4_t ancienne_temp = vld1q_f32(r.temperature + k);
+        const float32x4_t voisins = vaddq_f32(vaddq_f32(vaddq_f32(
+            vld1q_f32(r.dessus + k),
+            vld1q_f32(r.centre + k - 1 + P)),
+            vld1q_f32(r.centre + k + P)),
+            vld1q_f32(r.dessous + k));
+        const float32x4_t moyenne =
+            vaddq_f32(vmulq_f32(voisins, quart), bruit);
+        const float32x4_t nouvelle_temp = Plancher ?
+            vmaxq_f32(moyenne, vld1q_f32(r.chaleur + k)) : moyenne;
+        const float32x4_t delta_temp = vmulq_f32(conduct,
+            vsubq_f32(nouvelle_temp, ancienne_temp));
+
+        vst1q_f32(r.temperature + k, vaddq_f32(ancienne_temp, delta_temp));
+        somme = vaddq_f32(somme, vabsq_f32(delta_temp));
+    }
+
+    somme_delta += vaddvq_f32(somme);
+
+    // Derniers points de la rangée
+    RangeeDamier reste(r);
+    reste.debut = k;
+    return rangee_scalaire<ctc_t, P, Plancher>(reste, somme_delta);
+}
+
+const JeuNoyaux NOYAUX_NEON = {{
+    {rangee_neon<0, false>, rangee_neon<0, true>},
+    {rangee_neon<1, false>, rangee_neon<1, true>}
+}};
+#endif
+
+
+/**
+ * Choisir les meilleurs noyaux SIMD supportés par le processeur courant
+ * @param nom Nom des noyaux choisis
+ * @return Les noyaux à utiliser, ou les noyaux scalaires à défaut
+ */
+inline const JeuNoyaux & choisir_noyaux_simd(std::string & nom)
+{
+#if defined(CTC_AVX)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) {
+        nom = "avx512";
+        return NOYAUX_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        nom = "avx2";
+        return NOYAUX_AVX2;
+    }
+#elif defined(CTC_NEON)
+    nom = "neon";
+    return NOYAUX_NEON;
+#endif
+
+    nom = "scalaire";
+    return NOYAUX_SCALAIRES;
+}
+
+
+/**
+ * Modèle de grille 2D séparé selon les couleurs du damier.
+ *
+ * La couleur d'un point (i, j) est (i + j) % 2 : la couleur 0 est traitée
+ * en premier, puis la couleur 1. Chaque couleur est compactée dans ses
+ * propres plans de demi-largeur, de sorte que le point (i, j) est à
+ * l'indice j / 2 de la rangée i de sa couleur. Une passe d'une couleur
+ * parcourt donc ses plans de façon contiguë, et les quatre voisins d'un
+ * point sont dans les plans de l'autre couleur :
+ * dessus et dessous à l'indice k, gauche à k - 1 + p et droite à k + p,
+ * où p = (i + couleur) % 2 est la parité de la colonne j = 2k + p.
+ */
+class ModeleCTCDamier
+{
+public:
+    typedef IterateurCTC<ModeleCTCDamier, RefCTC> iterator;
+    typedef IterateurCTC<const ModeleCTCDamier, CTC> const_iterator;
+
+    ModeleCTCDamier():
+        larg(0), haut(0), demi(0), capacite(0), noyaux(NOYAUX_SCALAIRES),
+        nom("scalaire"), bruit(BRUIT), omega(1.), omega_auto(false),
+        nb_fils(0), tuiles(false), nb_tuiles_rangees(0),
+        nb_tuiles_colonnes(0), seuil_sommeil(SEUIL_CONVERGENCE / 4) {}
+
+    /**
+     * Appliquer les paramètres d'exécution au modèle
+     */
+    void configurer(const Configuration & config) {
+        bruit = config.bruit;
+        seuil_sommeil = config.seuil_sommeil();
+    }
+
+    /**
+     * Utiliser le meilleur noyau SIMD du processeur courant
+     */
+    void activer_simd() {
+        noyaux = choisir_noyaux_simd(nom);
+    }
+
+    /**
+     * Utiliser la sur-relaxation successive (SOR) projetée
+     * @param facteur Facteur de sur-relaxation, entre 1 et 2, ou 0 pour
+     *                l'estimer selon la taille de la grille
+     */
+    void activer_sor(ctc_t facteur) {
+        noyaux = NOYAUX_SOR;
+        nom = "sor";
+        omega_auto = (facteur == 0);
+        omega = omega_auto ? omega_optimal() : facteur;
+    }
+
+    /**
+     * Facteur de sur-relaxation utilisé par le noyau SOR
+     */
+    inline ctc_t facteur_omega() const { return omega; }
+
+    /**
+     * Nom du noyau de calcul utilisé
+     */
+    inline const std::string & nom_noyau() const { return nom; }
+
+    /**
+     * Répartir les rangées de chaque passe entre plusieurs fils d'exécution
+     * @param fils Nombre de fils OpenMP, ou 0 pour le calcul séquentiel
+     */
+    void activer_fils(int fils) {
+        nb_fils = fils;
+    }
+
+    /**
+     * Ne calculer que les tuiles actives : une tuile dont la variation
+     * moyenne reste sous le seuil de sommeil de la configuration pendant
+     * NB_PAS_SOMMEIL itérations
+     * est endormie, et une voisine qui varie la réveille. Les tuiles sans
+     * conduction ne sont jamais calculées.
+     */
+    void activer_tuiles() {
+        tuiles = true;
+    }
+
+    /**
+     * Analyser la grille une fois chargée : repérer les rangées de chaque
+     * couleur sans aucune chaleur, dont le noyau peut omettre le plancher,
+     * puis préparer les tuiles actives
+     */
+    void preparer() {
+        for (auto couleur = 0; couleur < 2; ++couleur) {
+            const VecteurGrille<ctc_t> & chaleur = plans[couleur].chaleur;
+
+            chauffee[couleur].assign(haut, 0);
+            for (std::size_t i = 0; i < haut; ++i) {
+                for (std::size_t k = i * demi; k < (i + 1) * demi; ++k) {
+                    if (chaleur[k] != 0) {
+                        chauffee[couleur][i] = 1;
+                        break;
+                    }
+                }
+            }
+        }
+
+        preparer_tuiles();
+    }
+
+    /**
+     * Compter les points intérieurs conducteurs de chaque tuile, marquer
+     * celles qui n'en ont aucun et réveiller toutes les autres
+     */
+    void preparer_tuiles() {
+        if (!tuiles)
+            return;
+
+        nb_tuiles_rangees = (haut + TUILE_RANGEES - 1) / TUILE_RANGEES;
+        nb_tuiles_colonnes = (demi + TUILE_COLONNES - 1) / TUILE_COLONNES;
+
+        const std::size_t nb_tuiles = nb_tuiles_rangees * nb_tuiles_colonnes;
+        std::vector<std::size_t> nb_conducteurs(nb_tuiles, 0);
+        tuile_calme.assign(nb_tuiles, 0);
+        sommes_tuiles.assign(nb_tuiles, 0.);
+
+        for (auto couleur = 0; couleur < 2; ++couleur) {
+            const VecteurGrille<ctc_t> & conduction =
+                plans[couleur].conduction;
+
+            // Points intérieurs seulement, comme les noyaux
+            for (std::size_t i = 1; i + 1 < haut; ++i) {
+                const std::size_t p = (i + couleur) & 1;
+
+                for (std::size_t k = 1 - p; k < (larg - p) / 2; ++k) {
+                    if (conduction[i * demi + k] != 0) {
+                        ++nb_conducteurs[(i / TUILE_RANGEES)
+                            * nb_tuiles_colonnes + k / TUILE_COLONNES];
+                    }
+                }
+            }
+        }
+
+        // Les noyaux ne donnent que la somme des variations : une tuile
+        // est calme selon sa moyenne sur ses points conducteurs, comparée
+        // à la somme permise. Une tuile de bord ou faite surtout de murs
+        // a ainsi un seuil à la mesure de ses points.
+        tuile_inerte.resize(nb_tuiles);
+        seuils_tuiles.resize(nb_tuiles);
+        for (std::size_t t = 0; t < nb_tuiles; ++t) {
+            tuile_inerte[t] = nb_conducteurs[t] == 0;
+            seuils_tuiles[t] = seuil_sommeil * nb_conducteurs[t];
+        }
+    }
+
+    /**
+     * Nombre de tuiles actuellement calculées
+     */
+    std::size_t nb_tuiles_actives() const {
+        std::size_t nb = 0;
+
+        for (std::size_t t = 0; t < tuile_calme.size(); ++t)
+            nb += active(t);
+
+        return nb;
+    }
+
+    /**
+     * Redimensionner la grille
+     */
+    void redimensionner(std::size_t largeur, std::size_t hauteur) {
+        larg = largeur;
+        haut = hauteur;
+        demi = (larg + 1) / 2;
+
+        if (omega_auto)
+            omega = omega_optimal();
+
+        // Seule une grille plus grande prend des pages neuves, touchées par
+        // leurs fils ; une plus petite réutilise les plans déjà alloués
+        if (demi * haut > capacite) {
+            capacite = demi * haut;
+            for (auto couleur = 0; couleur < 2; ++couleur) {
+                plans[couleur] = PlansCouleur();
+                plans[couleur].chaleur.resize(capacite);
+                plans[couleur].temperature.resize(capacite);
+                plans[couleur].conduction.resize(capacite);
+            }
+            toucher();
+        }
+        anciennes.resize(demi);
+    }
+
+    /**
+     * Copier des plans complets de largeur x hauteur valeurs dans la
+     * grille déjà dimensionnée : chaque rangée de chaque plan est répartie
+     * entre les deux couleurs, sans passer par les triplets
+     */
+    void copier_plans(const ctc_t * chaleur, const ctc_t * temperature,
+                      const ctc_t * conduction) {
+        for (std::size_t i = 0; i < haut; ++i) {
+            const std::size_t p = i & 1;  // Couleur de la colonne 0
+
+            repartir_rangee(chaleur + i * larg, i, p,
+                            &PlansCouleur::chaleur);
+            repartir_rangee(temperature + i * larg, i, p,
+                            &PlansCouleur::temperature);
+            repartir_rangee(conduction + i * larg, i, p,
+                            &PlansCouleur::conduction);
+        }
+    }
+
+    /**
+     * Accès à un triplet (Chaleur, Température, Conduction)
+     */
+    inline RefCTC ctc(std::size_t rangee, std::size_t colonne) {
+        PlansCouleur & p = plans[(rangee + colonne) & 1];
+        const std::size_t k = rangee * demi + colonne / 2;
+
+        return RefCTC(element(p.chaleur, k), element(p.temperature, k),
+            element(p.conduction, k));
+    }
+    inline CTC ctc(std::size_t rangee, std::size_t colonne) const {
+        const PlansCouleur & p = plans[(rangee + colonne) & 1];
+        const std::size_t k = rangee * demi + colonne / 2;
+
+        return CTC {element(p.chaleur, k), element(p.temperature, k),
+            element(p.conduction, k)};
+    }
+    inline RefCTC operator[](std::size_t k) {
+        return ctc(k / larg, k % larg);
+    }
+    inline CTC operator[](std::size_t k) const {
+        return ctc(k / larg, k % larg);
+    }
+
+    /**
+     * Accès à une composante
+     */
+    inline ctc_t chaleur(std::size_t rangee, std::size_t colonne) const {
+        return ctc(rangee, colonne).chaleur;
+    }
+    inline ctc_t temperature(std::size_t rangee, std::size_t colonne) const {
+        return ctc(rangee, colonne).temperature;
+    }
+    inline ctc_t conduction(std::size_t rangee, std::size_t colonne) const {
+        return ctc(rangee, colonne).conduction;
+    }
+
+    inline std::size_t largeur() const { return larg; }
+    inline std::size_t hauteur() const { return haut; }
+
+    inline iterator begin() { return iterator(this, 0); }
+    inline iterator end() { return iterator(this, larg * haut); }
+    inline const_iterator cbegin() const { return const_iterator(this, 0); }
+    inline const_iterator cend() const {
+        return const_iterator(this, larg * haut);
+    }
+
+    /**
+     * Effectuer une itération d'écoulement de chaleur sur toute la grille
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps() {
+        return iteration(NULL);
+    }
+
+    /**
+     * Effectuer une itération en accumulant ses statistiques
+     * @param stats Statistiques à compléter
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps(StatistiquesPas & stats) {
+        inclure_marge(*this, stats);
+        return iteration(&stats);
+    }
+
+    /**
+     * Effectuer une itération en répartissant les rangées entre les fils.
+     * Chaque rangée accumule ses propres variations, puis les sommes des
+     * rangées sont additionnées dans l'ordre : le résultat ne dépend donc
+     * pas du nombre de fils.
+     * @param stats Statistiques des points mis à jour à compléter, ou NULL
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps_parallele(StatistiquesPas * stats = NULL) {
+        const long nb_rangees = haut;
+        sommes_rangees.assign(haut, 0.);
+
+        #pragma omp parallel num_threads(nb_fils)
+        {
+            Releve releve(stats, demi);
+
+            for (auto couleur = 0; couleur < 2; ++couleur) {
+                // Barrière implicite en fin de boucle entre les deux couleurs
+                #pragma omp for schedule(static)
+                for (long i = 1; i < nb_rangees - 1; ++i) {
+                    sommes_rangees[i] = rangee(couleur, i, sommes_rangees[i],
+                        0, SIZE_MAX, releve.statistiques(), releve.tampon());
+                }
+            }
+
+            #pragma omp critical
+            releve.fusionner(stats);
+        }
+
+        return somme_rangees();
+    }
+
+    /**
+     * Effectuer une itération sur les seules tuiles actives, puis endormir
+     * les tuiles calmes et réveiller les voisines des tuiles qui varient.
+     * Les points d'une même couleur étant indépendants, une tuile active
+     * obtient les mêmes températures qu'avec un_pas_de_temps() ; les sommes
+     * des tuiles sont additionnées dans l'ordre, quel que soit le nombre
+     * de fils. Les tuiles inactives ne changent pas, mais leurs
+     * températures sont tout de même relues pour les statistiques.
+     * @param stats Statistiques des points intérieurs à compléter, ou NULL
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps_tuiles(StatistiquesPas * stats = NULL) {
+        const long nb_tuiles = sommes_tuiles.size();
+
+        sommes_tuiles.assign(nb_tuiles, 0.);
+
+        #pragma omp parallel num_threads(std::max(nb_fils, 1))
+        {
+            Releve releve(stats, demi);
+
+            for (auto couleur = 0; couleur < 2; ++couleur) {
+                #pragma omp for schedule(dynamic)
+                for (long t = 0; t < nb_tuiles; ++t) {
+                    if (active(t)) {
+                        sommes_tuiles[t] = tuile(couleur, t,
+                            sommes_tuiles[t], &releve);
+                    }
+                    else if (stats != NULL)
+                        inclure_tuile(couleur, t, *releve.statistiques());
+                }
+            }
+
+            #pragma omp critical
+            releve.fusionner(stats);
+        }
+
+        SommeCompensee somme_delta;
+
+        for (long t = 0; t < nb_tuiles; ++t) {
+            somme_delta.ajouter(sommes_tuiles[t]);
+
+            if (active(t)) {
+                if (sommes_tuiles[t] < seuils_tuiles[t])
+                    ++tuile_calme[t];
+                else
+                    tuile_calme[t] = 0;
+            }
+        }
+
+        reveiller_voisines();
+
+        return somme_delta.valeur() / (larg * haut);
+    }
+
+    /**
+     * Effectuer plusieurs itérations par tuilage temporel en front d'onde :
+     * les rangées défilent une seule fois dans la cache et chacune reçoit
+     * les nb_pas itérations pendant qu'elle y réside. Au front r, l'itération
+     * s (0..nb_pas-1) met à jour la couleur 0 de la rangée r - 2s, puis la
+     * couleur 1 de la rangée r - 2s - 1 ; ces rangées ont alors leurs voisines
+     * à la génération voulue, comme pour nb_pas appels à un_pas_de_temps().
+     *
+     * Le résultat est identique à nb_pas appels séparés, et la variation
+     * retournée est celle de la dernière itération, sommée par rangée
+     * comme avec un_pas_de_temps_parallele(). En mode multi-fils, les
+     * itérations sont plutôt effectuées une à une.
+     * @param nb_pas Nombre d'itérations à effectuer
+     * @param stats Statistiques de la dernière itération à compléter, ou NULL
+     * @return La différence de température moyenne de la dernière itération
+     */
+    ctc_t plusieurs_pas(unsigned int nb_pas, StatistiquesPas * stats = NULL) {
+        if (nb_pas == 0)
+            return 0.;
+        if (tuiles || nb_fils > 0) {
+            for (unsigned int s = 1; s < nb_pas; ++s)
+                un_pas_de_temps();
+            return stats != NULL ? un_pas_de_temps(*stats) :
+                un_pas_de_temps();
+        }
+        if (stats != NULL)
+            inclure_marge(*this, *stats);
+
+        const long nb_rangees = haut;
+        const long nb_niveaux = nb_pas;
+        const long dernier_front = nb_rangees - 2 + 2 * (nb_niveaux - 1) + 1;
+
+        sommes_rangees.assign(haut, 0.);
+
+        for (long front = 1; front <= dernier_front; ++front) {
+            for (long s = 0; s < nb_niveaux; ++s) {
+                const bool dernier = (s == nb_niveaux - 1);
+                const long i0 = front - 2 * s;
+                const long i1 = i0 - 1;
+
+                // Laisser faire la marge de 1 pixel
+                if (i0 >= 1 && i0 < nb_rangees - 1) {
+                    const ctc_t somme = rangee(0, i0, 0., 0, SIZE_MAX,
+                        dernier ? stats : NULL);
+                    if (dernier)
+                        sommes_rangees[i0] = somme;
+                }
+                if (i1 >= 1 && i1 < nb_rangees - 1) {
+                    const ctc_t somme = rangee(1, i1,
+                        dernier ? sommes_rangees[i1] : 0., 0, SIZE_MAX,
+                        dernier ? stats : NULL);
+                    if (dernier)
+                        sommes_rangees[i1] = somme;
+                }
+            }
+        }
+
+        return somme_rangees();
+    }
+
+private:
+    /**
+     * Plans compactés d'une couleur du damier
+     */
+    struct PlansCouleur {
+        VecteurGrille<ctc_t> chaleur;
+        VecteurGrille<ctc_t> temperature;
+        VecteurGrille<ctc_t> conduction;
+    };
+
+    /**
+     * Répartir une rangée complète d'un plan entre les deux couleurs
+     * @param source Rangée de larg valeurs
+     * @param i Numéro de la rangée
+     * @param p Couleur de la colonne 0 de la rangée
+     * @param plan Plan de chaque couleur à remplir
+     */
+    void repartir_rangee(const ctc_t * source, std::size_t i, std::size_t p,
+                         VecteurGrille<ctc_t> PlansCouleur::* plan) {
+        ctc_t * pairs = (plans[p].*plan).data() + i * demi;
+        ctc_t * impairs = (plans[p ^ 1].*plan).data() + i * demi;
+
+        for (std::size_t k = 0; 2 * k < larg; ++k)
+            pairs[k] = source[2 * k];
+        for (std::size_t k = 0; 2 * k + 1 < larg; ++k)
+            impairs[k] = source[2 * k + 1];
+    }
+
+    /**
+     * Statistiques d'un fil d'exécution et son tampon d'anciennes
+     * températures, vides sans statistiques demandées
+     */
+    class Releve {
+    public:
+        Releve(const StatistiquesPas * stats, std::size_t demi):
+            actif(stats != NULL), anciennes(actif ? demi : 0) {}
+
+        inline StatistiquesPas * statistiques() {
+            return actif ? &locales : NULL;
+        }
+        inline ctc_t * tampon() { return anciennes.data(); }
+
+        /**
+         * Ajouter les statistiques du fil à celles de l'itération
+         */
+        inline void fusionner(StatistiquesPas * stats) const {
+            if (actif)
+                stats->fusionner(locales);
+        }
+
+    private:
+        bool actif;
+        StatistiquesPas locales;
+        std::vector<ctc_t> anciennes;
+    };
+
+    /**
+     * Écrire une première fois des plans neufs, rangée par rangée avec la
+     * répartition statique des passes multi-fils : chaque page est placée
+     * sur le nœud NUMA du fil qui la calculera. Les tuiles actives sont
+     * réparties dynamiquement ; leurs pages sont seulement réparties entre
+     * les nœuds.
+     */
+    void toucher() {
+        const long nb_rangees = haut;
+
+        #pragma omp parallel for schedule(static) \
+            num_threads(std::max(nb_fils, 1))
+        for (long i = 1; i < nb_rangees - 1; ++i)
+            toucher_rangee(i);
+
+        // Marge du haut et du bas, hors des passes
+        toucher_rangee(0);
+        toucher_rangee(haut - 1);
+    }
+
+    /**
+     * Remettre à zéro une rangée des plans des deux couleurs
+     */
+    void toucher_rangee(std::size_t i) {
+        for (auto couleur = 0; couleur < 2; ++couleur) {
+            PlansCouleur & p = plans[couleur];
+
+            std::fill_n(p.chaleur.data() + i * demi, demi, ctc_t(0));
+            std::fill_n(p.temperature.data() + i * demi, demi, ctc_t(0));
+            std::fill_n(p.conduction.data() + i * demi, demi, ctc_t(0));
+        }
+    }
+
+    /**
+     * Itération séquentielle, ou répartie selon le mode choisi
+     * @param stats Statistiques des points intérieurs à compléter, ou NULL
+     * @return La différence de température moyenne
+     */
+    ctc_t iteration(StatistiquesPas * stats) {
+        if (tuiles)
+            return un_pas_de_temps_tuiles(stats);
+        if (nb_fils > 0)
+            return un_pas_de_temps_parallele(stats);
+
+        sommes_rangees.assign(haut, 0.);
+
+        // Une passe contiguë par couleur
+        for (auto couleur = 0; couleur < 2; ++couleur) {
+            // Laisser faire la marge de 1 pixel
+            for (std::size_t i = 1; i < haut - 1; ++i) {
+                sommes_rangees[i] = rangee(couleur, i, sommes_rangees[i],
+                                           0, SIZE_MAX, stats);
+            }
+        }
+
+        return somme_rangees();
+    }
+
+    /**
+     * Additionner les variations des rangées, dans l'ordre et avec
+     * compensation : le résultat est le même en séquentiel, en front
+     * d'onde et quel que soit le nombre de fils
+     * @return La différence de température moyenne
+     */
+    ctc_t somme_rangees() const {
+        SommeCompensee somme_delta;
+
+        for (std::size_t i = 1; i + 1 < haut; ++i)
+            somme_delta.ajouter(sommes_rangees[i]);
+
+        return somme_delta.valeur() / (larg * haut);
+    }
+
+    /**
+     * Mettre à jour les points d'une couleur sur une rangée. Avec des
+     * statistiques, les anciennes températures de la rangée sont d'abord
+     * copiées dans un tampon : le noyau reste le même, et la rangée encore
+     * en cache est relue pour ses extrêmes et sa plus grande variation.
+     * @param couleur Couleur à mettre à jour
+     * @param i Rangée à traiter
+     * @param somme_delta Somme des variations accumulée jusqu'ici
+     * @param kmin Premier indice compacté à traiter, au plus tôt
+     * @param kmax Indice compacté suivant le dernier à traiter, au plus tard
+     * @param stats Statistiques à compléter, ou NULL
+     * @param tampon Anciennes températures (demi valeurs) ; NULL pour celui
+     *               du modèle, en calcul séquentiel
+     * @return La somme accumulée incluant les variations de la rangée
+     */
+    ctc_t rangee(int couleur, std::size_t i, ctc_t somme_delta,
+                 std::size_t kmin = 0, std::size_t kmax = SIZE_MAX,
+                 StatistiquesPas * stats = NULL, ctc_t * tampon = NULL) {
+        PlansCouleur & ici = plans[couleur];
+        const PlansCouleur & autre = plans[couleur ^ 1];
+        RangeeDamier r;
+
+        r.chaleur = ici.chaleur.data() + i * demi;
+        r.conduction = ici.conduction.data() + i * demi;
+        r.temperature = ici.temperature.data() + i * demi;
+        r.dessus = autre.temperature.data() + (i - 1) * demi;
+        r.centre = autre.temperature.data() + i * demi;
+        r.dessous = autre.temperature.data() + (i + 1) * demi;
+        r.p = (i + couleur) & 1;
+        r.debut = std::max(1 - r.p, kmin);
+        r.fin = std::min((larg - r.p) / 2, kmax);
+        r.bruit = bruit;
+        r.omega = omega;
+
+        if (r.debut >= r.fin)
+            return somme_delta;
+
+        const NoyauDamier noyau = noyaux.choisir(r.p, plancher(couleur, i));
+
+        if (stats == NULL)
+            return noyau(r, somme_delta);
+
+        ctc_t * ancienne = (tampon != NULL ? tampon : anciennes.data());
+
+        std::copy(r.temperature + r.debut, r.temperature + r.fin,
+                  ancienne + r.debut);
+        somme_delta = noyau(r, somme_delta);
+        inclure_rangee(r.temperature + r.debut, ancienne + r.debut,
+                       r.fin - r.debut, *stats);
+
+        return somme_delta;
+    }
+
+    /**
+     * Inclure dans les statistiques les températures d'une couleur d'une
+     * tuile inactive, sans les mettre à jour
+     * @param couleur Couleur à relire
+     * @param t Indice de la tuile
+     * @param stats Statistiques à compléter
+     */
+    void inclure_tuile(int couleur, std::size_t t,
+                       StatistiquesPas & stats) const {
+        const std::size_t rangee0 = (t / nb_tuiles_colonnes) * TUILE_RANGEES;
+        const std::size_t k0 = (t % nb_tuiles_colonnes) * TUILE_COLONNES;
+        const VecteurGrille<ctc_t> & temperature = plans[couleur].temperature;
+
+        for (std::size_t i = std::max<std::size_t>(rangee0, 1);
+             i < std::min(rangee0 + TUILE_RANGEES, haut - 1); ++i) {
+            const std::size_t p = (i + couleur) & 1;
+
+            // Points intérieurs seulement, comme les noyaux
+            for (std::size_t k = std::max<std::size_t>(k0, 1 - p);
+                 k < std::min(k0 + TUILE_COLONNES, (larg - p) / 2); ++k)
+                stats.inclure(temperature[i * demi + k]);
+        }
+    }
+
+    /**
+     * Vrai si la chaleur de la rangée peut borner la température cible.
+     * Les températures restant positives, une cible sans chaleur garde
+     * sa valeur si le bruit est positif ; sans analyse de la grille
+     * (preparer), le plancher est toujours appliqué.
+     */
+    inline bool plancher(int couleur, std::size_t i) const {
+        return bruit < 0 || chauffee[couleur].empty() || chauffee[couleur][i];
+    }
+
+    /**
+     * Mettre à jour les points d'une couleur dans une tuile
+     * @param couleur Couleur à mettre à jour
+     * @param t Indice de la tuile
+     * @param somme_delta Somme des variations accumulée jusqu'ici
+     * @param releve Statistiques et tampon du fil, ou NULL
+     * @return La somme accumulée incluant les variations de la tuile
+     */
+    ctc_t tuile(int couleur, std::size_t t, ctc_t somme_delta,
+                Releve * releve = NULL) {
+        const std::size_t rangee0 = (t / nb_tuiles_colonnes) * TUILE_RANGEES;
+        const std::size_t k0 = (t % nb_tuiles_colonnes) * TUILE_COLONNES;
+        const std::size_t k1 = k0 + TUILE_COLONNES;
+
+        // Laisser faire la marge de 1 pixel
+        for (std::size_t i = std::max<std::size_t>(rangee0, 1);
+             i < std::min(rangee0 + TUILE_RANGEES, haut - 1); ++i) {
+            somme_delta = rangee(couleur, i, somme_delta, k0, k1,
+                releve != NULL ? releve->statistiques() : NULL,
+                releve != NULL ? releve->tampon() : NULL);
+        }
+
+        return somme_delta;
+    }
+
+    /**
+     * Réveiller les tuiles endormies voisines d'une tuile qui varie
+     */
+    void reveiller_voisines() {
+        const long nb_r = nb_tuiles_rangees;
+        const long nb_c = nb_tuiles_colonnes;
+
+        for (long tr = 0; tr < nb_r; ++tr) {
+            for (long tc = 0; tc < nb_c; ++tc) {
+                const long t = tr * nb_c + tc;
+
+                if (tuile_inerte[t] || active(t))
+                    continue;
+
+                const bool reveil =
+                    (tr > 0 && agitee(t - nb_c)) ||
+                    (tr + 1 < nb_r && agitee(t + nb_c)) ||
+                    (tc > 0 && agitee(t - 1)) ||
+                    (tc + 1 < nb_c && agitee(t + 1));
+
+                if (reveil)
+                    tuile_calme[t] = 0;
+            }
+        }
+    }
+
+    /**
+     * Vrai si la dernière variation de la tuile dépasse son seuil de sommeil
+     */
+    inline bool agitee(std::size_t t) const {
+        return !tuile_inerte[t] && sommes_tuiles[t] >= seuils_tuiles[t];
+    }
+
+    /**
+     * Vrai si la tuile doit être calculée
+     */
+    inline bool active(std::size_t t) const {
+        return !tuile_inerte[t] && tuile_calme[t] < NB_PAS_SOMMEIL;
+    }
+
+    /**
+     * Facteur optimal de sur-relaxation pour l'équation de Laplace sur
+     * une grille de n points de côté : 2 / (1 + sin(pi / n))
+     */
+    ctc_t omega_optimal() const {
+        const double n = std::max<std::size_t>(std::max(larg, haut), 2);
+
+        return 2. / (1. + std::sin(M_PI / n));
+    }
+
+    std::size_t larg;
+    std::size_t haut;
+    std::size_t demi;  // Largeur des plans compactés
+    std::size_t capacite;  // Points alloués dans les plans de chaque couleur
+
+    PlansCouleur plans[2];
+    std::vector<char> chauffee[2];  // Rangées de chaque couleur avec chaleur
+    JeuNoyaux noyaux;
+    std::string nom;
+    ctc_t bruit;      // Bruit ajouté à la moyenne des températures voisines
+    ctc_t omega;      // Facteur de sur-relaxation du noyau SOR
+    bool omega_auto;  // Estimer omega selon la taille de la grille
+
+    int nb_fils;
+    std::vector<ctc_t> sommes_rangees;  // Variations de chaque rangée
+    std::vector<ctc_t> anciennes;  // Rangée avant mise à jour (statistiques)
+
+    // Tuiles actives
+    static const std::size_t TUILE_RANGEES = 16;
+    static const std::size_t TUILE_COLONNES = 64;  // Indices compactés
+
+    bool tuiles;
+    std::size_t nb_tuiles_rangees;
+    std::size_t nb_tuiles_colonnes;
+    std::vector<char> tuile_inerte;            // Sans aucune conduction
+    std::vector<unsigned int> tuile_calme;     // Itérations calmes de suite
+    std::vector<ctc_t> sommes_tuiles;          // Variations de chaque tuile
+    std::vector<ctc_t> seuils_tuiles;          // Somme permise à une tuile calme
+    ctc_t seuil_sommeil;  // Variation moyenne d'un point d'une tuile calme
+};
+
+
+/**
+ * Modèle en plans séparés calculé sur un accélérateur (GPU) par
+ * déchargement OpenMP (target). Les plans restent dans la mémoire de
+ * l'accélérateur pendant toute la boucle de convergence, et seules les
+ * températures sont recopiées à la fin. Chaque couleur est un noyau
+ * distinct ; seule la dernière itération d'un lot calcule la somme des
+ * variations, par une réduction sur l'accélérateur, ce qui évite de
+ * synchroniser l'hôte à chaque itération. Sans accélérateur, les noyaux
+ * s'exécutent sur l'hôte.
+ */
+class ModeleCTCGPU: public ModeleCTCPlans
+{
+public:
+    ModeleCTCGPU(): sur_gpu(false), gpu_chaleur(NULL), gpu_conduction(NULL),
+        gpu_temperature(NULL), gpu_points(0) {}
+
+    virtual ~ModeleCTCGPU() {
+        liberer_gpu();
+    }
+
+    /**
+     * Copier la grille dans la mémoire de l'accélérateur
+     */
+    void transferer_vers_gpu() {
+        gpu_chaleur = plan_chaleur.data();
+        gpu_conduction = plan_conduction.data();
+        gpu_temperature = plan_temperature.data();
+        gpu_points = larg * haut;
+
+        #pragma omp target enter data map(to: gpu_chaleur[0:gpu_points], \
+            gpu_conduction[0:gpu_points], gpu_temperature[0:gpu_points])
+        sur_gpu = true;
+    }
+
+    /**
+     * Recopier les températures sur l'hôte et libérer l'accélérateur
+     */
+    void recuperer_temperatures() {
+        if (!sur_gpu)
+            return;
+
+        synchroniser_temperatures();
+        liberer_gpu();
+    }
+
+    /**
+     * Recopier sur l'accélérateur les températures modifiées sur l'hôte
+     */
+    void envoyer_temperatures() {
+        if (!sur_gpu)
+            return;
+
+        #pragma omp taskwait
+        #pragma omp target update to(gpu_temperature[0:gpu_points])
+    }
+
+    /**
+     * Recopier les températures sur l'hôte en gardant l'accélérateur,
+     * une fois les lots en cours terminés
+     */
+    void synchroniser_temperatures() {
+        if (!sur_gpu)
+            return;
+
+        #pragma omp taskwait
+        #pragma omp target update from(gpu_temperature[0:gpu_points])
+    }
+
+    /**
+     * Effectuer une itération d'écoulement de chaleur sur toute la grille
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps() {
+        return plusieurs_pas(1);
+    }
+
+    /**
+     * Effectuer une itération en accumulant ses statistiques
+     * @param stats Statistiques à compléter
+     * @return La différence de température moyenne
+     */
+    ctc_t un_pas_de_temps(StatistiquesPas & stats) {
+        return plusieurs_pas(1, &stats);
+    }
+
+    /**
+     * Effectuer un lot d'itérations sans synchroniser l'hôte, sauf pour
+     * les réductions de la dernière itération. La marge, qui ne change
+     * pas, est lue sur l'hôte.
+     * @param nb_pas Nombre d'itérations à effectuer
+     * @param stats Statistiques de la dernière itération à compléter, ou NULL
+     * @return La différence de température moyenne de la dernière itération
+     */
+    ctc_t plusieurs_pas(unsigned int nb_pas, StatistiquesPas * stats = NULL) {
+        if (nb_pas == 0)
+            return 0.;
+
+        for (unsigned int s = 1; s < nb_pas; ++s) {
+            passe(0);
+            passe(1);
+        }
+
+        StatistiquesPas locales;
+        ctc_t somme_delta = passe_reduction(0, locales);
+        somme_delta += passe_reduction(1, locales);
+
+        if (stats != NULL) {
+            inclure_marge(*this, *stats);
+            stats->fusionner(locales);
+        }
+
+        return somme_delta / (larg * haut);
+    }
+
+private:
+    /**
+     * Noyau asynchrone d'une couleur, sans somme des variations
+     * @param couleur Couleur du damier à traiter
+     */
+    void passe(int couleur) {
+        const long L = larg, H = haut, demi = (L - 1) / 2;
+        const ctc_t b = bruit;
+        const ctc_t * ch = plan_chaleur.data();
+        const ctc_t * co = plan_conduction.data();
+        ctc_t * te = plan_temperature.data();
+
+        #pragma omp target teams distribute parallel for collapse(2) \
+            nowait depend(inout: te[0])
+        for (long i = 1; i < H - 1; ++i) {
+            for (long jj = 0; jj < demi; ++jj) {
+                const long j = 1 + (((i + 1) ^ couleur) & 1) + 2 * jj;
+
+                if (j < L - 1) {
+                    const long k = i * L + j;
+                    ctc_t nouvelle_temp = std::max(ch[k], (
+                        te[k - L] +
+                        te[k - 1] +
+                        te[k + 1] +
+                        te[k + L] ) / 4 + b);
+
+                    te[k] += co[k] * (nouvelle_temp - te[k]);
+                }
+            }
+        }
+    }
+
+    /**
+     * Noyau d'une couleur avec réduction des variations et des extrêmes
+     * sur l'accélérateur ; une couleur ne change plus après sa passe
+     * @param couleur Couleur du damier à traiter
+     * @param stats Statistiques des points de cette couleur à compléter
+     * @return La somme des variations de cette couleur
+     */
+    ctc_t passe_reduction(int couleur, StatistiquesPas & stats) {
+        const long L = larg, H = haut, demi = (L - 1) / 2;
+        const ctc_t b = bruit;
+        const ctc_t * ch = plan_chaleur.data();
+        const ctc_t * co = plan_conduction.data();
+        ctc_t * te = plan_temperature.data();
+        ctc_t somme_delta = 0.;
+        ctc_t t_min = stats.t_min, t_max = stats.t_max;
+        ctc_t delta_max = stats.delta_max;
+
+        #pragma omp target teams distribute parallel for collapse(2) \
+            reduction(+: somme_delta) reduction(min: t_min) \
+            reduction(max: t_max, delta_max) \
+            map(tofrom: somme_delta, t_min, t_max, delta_max) \
+            depend(inout: te[0])
+        for (long i = 1; i < H - 1; ++i) {
+            for (long jj = 0; jj < demi; ++jj) {
+                const long j = 1 + (((i + 1) ^ couleur) & 1) + 2 * jj;
+
+                if (j < L - 1) {
+                    const long k = i * L + j;
+                    ctc_t nouvelle_temp = std::max(ch[k], (
+                        te[k - L] +
+                        te[k - 1] +
+                        te[k + 1] +
+                        te[k + L] ) / 4 + b);
+                    ctc_t delta_temp = co[k] * (nouvelle_temp - te[k]);
+
+                    te[k] += delta_temp;
+                    somme_delta += std::abs(delta_temp);
+                    t_min = std::min(t_min, te[k]);
+                    t_max = std::max(t_max, te[k]);
+                    delta_max = std::max(delta_max, std::abs(delta_temp));
+                }
+            }
+        }
+
+        stats.t_min = t_min;
+        stats.t_max = t_max;
+        stats.delta_max = delta_max;
+
+        return somme_delta;
+    }
+
+    /**
+     * Libérer la mémoire de l'accélérateur
+     */
+    void liberer_gpu() {
+        if (!sur_gpu)
+            return;
+
+        #pragma omp taskwait
+        #pragma omp target exit data map(delete: gpu_chaleur[0:gpu_points], \
+            gpu_conduction[0:gpu_points], gpu_temperature[0:gpu_points])
+        sur_gpu = false;
+    }
+
+    bool sur_gpu;  // Vrai si la grille est dans la mémoire de l'accélérateur
+
+    // Plans de l'hôte placés sur l'accélérateur, libérés tels quels même si
+    // la grille a été redimensionnée depuis
+    const ctc_t * gpu_chaleur;
+    const ctc_t * gpu_conduction;
+    ctc_t * gpu_temperature;
+    std::size_t gpu_points;
+};
+
+
+/**
+ * Normaliser la température selon les températures minimale et maximale.
+ * Convertir cette valeur de 0..1 en couleur sur un dégradé de noir, à bleu,
+ * à magenta, à rouge, à jaune et à blanc, selon une courbe de Bézier.
+ *
+ * @param temp Température à normaliser
+ * @param t_min Température minimale mesurée
+ * @param t_max Température maximale mesurée
+ * @return Pixel RGB de type png_color selon la valeur de temp.
+ */
+inline png_color normaliser_couleur(ctc_t temp, ctc_t t_min, ctc_t t_max)
+{
+    const ctc_t t = (temp - t_min) / (t_max - t_min);
+    std::vector<std::array<double, 3>> couleurs {{
+       {  0,   0,   0},  // Noir
+       {  0,   0, 255},  // Bleu
+       {255,   0, 255},  // Magenta
+       {255,   0,   0},  // Rouge
+       {255, 255,   0},  // Jaune
+       {255, 255, 255}   // Blanc
+    }};
+
+    // Calcul itératif de la courbe de Bézier dans l'espace des couleurs
+    for (std::size_t iter = 1; iter < couleurs.size(); ++iter) {
+        for (std::size_t i = 0; i < couleurs.size() - iter; ++i) {
+            couleurs[i][0] += t * (couleurs[i + 1][0] - couleurs[i][0]);
+            couleurs[i][1] += t * (couleurs[i + 1][1] - couleurs[i][1]);
+            couleurs[i][2] += t * (couleurs[i + 1][2] - couleurs[i][2]);
+        }
+    }
+
+    return png_color {
+        (png_byte)couleurs[0][0],
+        (png_byte)couleurs[0][1],
+        (png_byte)couleurs[0][2]
+    };
+}
+
+
+/**
+ * Palette précalculée du dégradé de normaliser_couleur() : la courbe de
+ * Bézier n'est évaluée qu'une fois pour TAILLE valeurs réparties de 0 à 1,
+ * et chaque température est ensuite quantifiée vers l'entrée la plus
+ * proche. L'écart avec le calcul exact est d'au plus une demi-entrée.
+ */
+class PaletteCouleurs
+{
+public:
+    static const std::size_t TAILLE = 4096;
+    static const long RANGEES_BANDE = 64;  // Rangées colorées ensemble
+
+    PaletteCouleurs(): table(TAILLE), minimum(0.), echelle(0.) {
+        for (std::size_t q = 0; q < TAILLE; ++q)
+            table[q] = normaliser_couleur(ctc_t(q) / (TAILLE - 1), 0., 1.);
+    }
+
+    /**
+     * Fixer l'intervalle de températures couvert par le dégradé
+     * @param t_min Température minimale mesurée
+     * @param t_max Température maximale mesurée
+     */
+    void etalonner(ctc_t t_min, ctc_t t_max) {
+        minimum = t_min;
+        echelle = t_max > t_min ? (TAILLE - 1) / (t_max - t_min) : 0.;
+    }
+
+    /**
+     * Couleur d'une température, dans l'intervalle étalonné. La position
+     * est bornée avant sa conversion entière : une température hors de
+     * portée ou NaN (comparaison toujours fausse) prend une extrémité.
+     */
+    inline png_color operator()(ctc_t temp) const {
+        const ctc_t position = (temp - minimum) * echelle + ctc_t(0.5);
+
+        if (!(position >= 0))
+            return table[0];
+        if (position >= TAILLE - 1)
+            return table[TAILLE - 1];
+        return table[std::size_t(position)];
+    }
+
+    /**
+     * Exporter les températures d'un modèle par bandes de RANGEES_BANDE
+     * rangées, colorées en parallèle par les fils OpenMP puis compressées
+     * @param carte Modèle dont les températures sont exportées
+     * @param sortie Fichier ouvert aux dimensions du modèle
+     * @param rapport Mesures recevant les durées de coloration et
+     *                d'écriture, ou NULL
+     */
+    template <class Modele>
+    void exporter(const Modele & carte, EcrivainPNG & sortie,
+                  RapportCalcul * rapport = NULL) const {
+        const long haut = carte.hauteur();
+        const std::size_t larg = carte.largeur();
+        std::vector<png_color> bande(RANGEES_BANDE * larg);
+        double coloration = 0.;
+        double ecriture = 0.;
+
+        for (long debut = 0; debut < haut; debut += RANGEES_BANDE) {
+            const long fin = std::min<long>(haut, debut + RANGEES_BANDE);
+            auto instant = std::chrono::steady_clock::now();
+
+            #pragma omp parallel for schedule(static)
+            for (long i = debut; i < fin; ++i) {
+                png_color * pixels = bande.data() + (i - debut) * larg;
+
+                for (std::size_t j = 0; j < larg; ++j)
+                    pixels[j] = (*this)(carte.temperature(i, j));
+            }
+
+            coloration += secondes_depuis(instant);
+            instant = std::chrono::steady_clock::now();
+
+            for (long i = debut; i < fin; ++i)
+                sortie.ecrire_rangee(bande.data() + (i - debut) * larg);
+
+            ecriture += secondes_depuis(instant);
+        }
+
+        if (rapport != NULL) {
+            rapport->secondes[PHASE_COLORATION] += coloration;
+            rapport->secondes[PHASE_ECRITURE] += ecriture;
+        }
+    }
+
+    /**
+     * Exporter un plan de températures rangée par rangée. Sans équipe
+     * OpenMP : l'appelant est le fil des instantanés, qui ne doit pas
+     * disputer les cœurs au solveur.
+     * @param temperatures Températures de l'image, dans l'ordre des pixels
+     * @param larg Largeur de l'image
+     * @param sortie Fichier ouvert aux dimensions de l'image
+     */
+    void exporter(const std::vector<ctc_t> & temperatures, std::size_t larg,
+                  EcrivainPNG & sortie) const {
+        std::vector<png_color> rangee(larg);
+
+        for (auto temp = temperatures.cbegin(); temp != temperatures.cend();
+             temp += larg) {
+            std::transform(temp, temp + larg, rangee.begin(),
+                [this](ctc_t t) { return (*this)(t); });
+            sortie.ecrire_rangee(rangee.data());
+        }
+    }
+
+private:
+    std::vector<png_color> table;
+    ctc_t minimum;
+    ctc_t echelle;  // Entrées de la table par degré
+};
+
+
+/**
+ * Vérifier qu'un motif de nom de fichier contient exactement une
+ * conversion %u ou %d (avec drapeaux et largeur), et seulement des %%
+ */
+inline bool motif_valide(const std::string & motif)
+{
+    unsigned int nb_conversions = 0;
+
+    for (std::size_t k = 0; k < motif.size(); ++k) {
+        if (motif[k] != '%')
+            continue;
+        if (k + 1 < motif.size() && motif[k + 1] == '%') {
+            ++k;
+            continue;
+        }
+
+        k = motif.find_first_not_of("0123456789-+ #", k + 1);
+        if (k == std::string::npos || (motif[k] != 'u' && motif[k] != 'd'))
+            return false;
+        ++nb_conversions;
+    }
+
+    return nb_conversions == 1;
+}
+
+
+/**
+ * Écriture des instantanés en cours de calcul par un fil dédié : le
+ * solveur ne fait que recopier les températures dans un tampon libre, et
+ * la coloration et la compression PNG se font en parallèle. Les tampons
+ * sont en nombre fixe (double tampon par défaut) : la mémoire est bornée,
+ * et le solveur n'attend que si tous sont encore en file d'écriture.
+ */
+class EcrivainInstantanes
+{
+public:
+    /**
+     * @param larg Largeur de la grille
+     * @param haut Hauteur de la grille
+     * @param motif Nom des fichiers, printf avec le numéro d'itération
+     * @param nb_tampons Nombre maximal d'instantanés en mémoire
+     */
+    EcrivainInstantanes(std::size_t larg, std::size_t haut,
+                        const std::string & motif,
+                        std::size_t nb_tampons = 2):
+        larg(larg), haut(haut), motif(motif),
+        libres(nb_tampons, std::vector<ctc_t>(larg * haut)), arret(false),
+        fil(&EcrivainInstantanes::ecrire, this) {}
+
+    /**
+     * Écrire les instantanés restant en file et arrêter le fil
+     */
+    ~EcrivainInstantanes() {
+        {
+            std::lock_guard<std::mutex> verrou(acces);
+            arret = true;
+        }
+        changement.notify_all();
+        fil.join();
+    }
+
+    EcrivainInstantanes(const EcrivainInstantanes &) = delete;
+    EcrivainInstantanes & operator=(const EcrivainInstantanes &) = delete;
+
+    /**
+     * Recopier les températures d'un modèle et les confier au fil
+     * d'écriture, après avoir attendu un tampon libre
+     * @param carte Modèle aux températures accessibles sur l'hôte
+     * @param nb_iter Numéro d'itération, pour le nom du fichier
+     * @param stats Statistiques de la dernière itération, dont les
+     *              extrêmes étalonnent l'image, ou NULL pour les mesurer
+     */
+    template <class Modele>
+    void capturer(const Modele & carte, unsigned int nb_iter,
+                  const StatistiquesPas * stats = NULL) {
+        Instantane instantane;
+
+        instantane.nb_iter = nb_iter;
+        if (stats != NULL)
+            instantane.stats = *stats;
+        {
+            std::unique_lock<std::mutex> verrou(acces);
+            changement.wait(verrou, [this] { return !libres.empty(); });
+            instantane.temperatures.swap(libres.back());
+            libres.pop_back();
+        }
+
+        ctc_t * temp = instantane.temperatures.data();
+
+        for (std::size_t i = 0; i < haut; ++i)
+            for (std::size_t j = 0; j < larg; ++j)
+                *temp++ = carte.temperature(i, j);
+
+        {
+            std::lock_guard<std::mutex> verrou(acces);
+            file.push_back(std::move(instantane));
+        }
+        changement.notify_all();
+    }
+
+private:
+    struct Instantane {
+        unsigned int nb_iter;
+        StatistiquesPas stats;  // Extrêmes, s'ils sont déjà connus
+        std::vector<ctc_t> temperatures;
+    };
+
+    /**
+     * Boucle du fil d'écriture, jusqu'à l'arrêt et une file vide
+     */
+    void ecrire() {
+        PaletteCouleurs palette;
+
+        for (;;) {
+            Instantane instantane;
+            {
+                std::unique_lock<std::mutex> verrou(acces);
+                changement.wait(verrou,
+                    [this] { return arret || !file.empty(); });
+                if (file.empty())
+                    return;
+                instantane = std::move(file.front());
+                file.pop_front();
+            }
+
+            if (instantane.stats.valides()) {
+                palette.etalonner(instantane.stats.t_min,
+                                  instantane.stats.t_max);
+            }
+            else {
+                const auto minmax = std::minmax_element(
+                    instantane.temperatures.cbegin(),
+                    instantane.temperatures.cend());
+
+                palette.etalonner(*minmax.first, *minmax.second);
+            }
+
+            // La largeur du %u n'est pas bornée : mesurer le nom d'abord
+            const int longueur = std::snprintf(NULL, 0, motif.c_str(),
+                                               instantane.nb_iter);
+            std::vector<char> nom(std::max(longueur, 0) + 1);
+            std::snprintf(nom.data(), nom.size(), motif.c_str(),
+                          instantane.nb_iter);
+
+            try {
+                EcrivainPNG sortie;
+
+                sortie.ouvrir(nom.data(), larg, haut);
+                palette.exporter(instantane.temperatures, larg, sortie);
+                sortie.fermer();
+            }
+            catch (const std::string message) {
+                std::cerr << "Erreur: " << message << std::endl;
+            }
+
+            {
+                std::lock_guard<std::mutex> verrou(acces);
+                libres.push_back(std::move(instantane.temperatures));
+            }
+            changement.notify_all();
+        }
+    }
+
+    const std::size_t larg;
+    const std::size_t haut;
+    const std::string motif;
+    std::vector<std::vector<ctc_t>> libres;  // Tampons disponibles
+    std::deque<Instantane> file;             // Instantanés à écrire
+    bool arret;
+    std::mutex acces;
+    std::condition_variable changement;
+    std::thread fil;  // Dernier membre : démarré une fois les autres prêts
+};
+
+
+/**
+ * En-tête d'un fichier de sauvegarde, suivi des plans de chaleur, de
+ * température et de conduction (largeur x hauteur valeurs ctc_t chacun,
+ * rangée par rangée, dans l'ordre des octets de la machine). Ses 64 octets
+ * gardent les plans alignés pour une lecture directe par mmap. Le format
+ * est le même pour la solution MPI.
+ */
+struct EnteteSauvegarde {
+    char signature[8];        // SIGNATURE_SAUVEGARDE
+    std::uint32_t taille_ctc; // sizeof(ctc_t) des plans
+    std::uint32_t largeur;
+    std::uint32_t hauteur;
+    std::uint32_t nb_iter;    // Itérations effectuées
+    double delta_temp;        // Ajustement moyen de la dernière itération
+    double bruit;
+    double seuil_convergence;
+    std::uint32_t nb_max_iter;
+    std::uint32_t reserve[3];
+};
+
+static_assert(sizeof(EnteteSauvegarde) == 64,
+              "En-tête de sauvegarde de 64 octets");
+
+const char SIGNATURE_SAUVEGARDE[8] = {'C', 'T', 'C', 'S', 'A', 'U', 'V', '1'};
+
+/**
+ * Enregistrer l'état d'un modèle dans un fichier de sauvegarde. Le fichier
+ * est d'abord écrit sous un nom temporaire puis renommé : une sauvegarde
+ * interrompue ne remplace pas la précédente.
+ * @param carte Modèle aux températures accessibles sur l'hôte
+ * @param config Paramètres du calcul, conservés dans l'en-tête
+ * @param nb_iter Itérations effectuées
+ * @param delta_temp Ajustement moyen de la dernière itération
+ * @return Faux si l'écriture a échoué, avec un message d'erreur affiché
+ */
+template <class Modele>
+bool sauvegarder(const Modele & carte, const Configuration & config,
+                 unsigned int nb_iter, ctc_t delta_temp)
+{
+    const std::size_t larg = carte.largeur();
+    const std::size_t haut = carte.hauteur();
+    const std::string temporaire = config.sauvegarde + ".tmp";
+    EnteteSauvegarde entete;
+
+    memset(&entete, 0, sizeof entete);
+    memcpy(entete.signature, SIGNATURE_SAUVEGARDE, sizeof entete.signature);
+    entete.taille_ctc = sizeof(ctc_t);
+    entete.largeur = larg;
+    entete.hauteur = haut;
+    entete.nb_iter = nb_iter;
+    entete.delta_temp = delta_temp;
+    entete.bruit = config.bruit;
+    entete.seuil_convergence = config.seuil_convergence;
+    entete.nb_max_iter = config.nb_max_iter;
+
+    std::FILE * fichier = std::fopen(temporaire.c_str(), "wb");
+    bool ecrit = fichier != NULL &&
+        std::fwrite(&entete, sizeof entete, 1, fichier) == 1;
+
+    // Un plan à la fois, une rangée à la fois
+    std::vector<ctc_t> rangee(larg);
+
+    for (int p = 0; p < 3 && ecrit; ++p) {
+        for (std::size_t i = 0; i < haut && ecrit; ++i) {
+            for (std::size_t j = 0; j < larg; ++j) {
+                const CTC point = carte.ctc(i, j);
+                rangee[j] = p == 0 ? point.chaleur :
+                    p == 1 ? point.temperature : point.conduction;
+            }
+            ecrit = std::fwrite(rangee.data(), sizeof(ctc_t), larg, fichier)
+                == larg;
+        }
+    }
+
+    if (fichier != NULL && std::fclose(fichier) != 0)
+        ecrit = false;
+    if (ecrit && std::rename(temporaire.c_str(), config.sauvegarde.c_str()))
+        ecrit = false;
+
+    if (!ecrit) {
+        std::cerr << "Erreur: " << config.sauvegarde << " - "
+            << std::strerror(errno) << std::endl;
+        std::remove(temporaire.c_str());
+    }
+
+    return ecrit;
+}
+
+/**
+ * Fichier de sauvegarde projeté en mémoire (mmap) : les plans sont lus
+ * directement depuis le cache de pages, sans tampon intermédiaire. La
+ * projection est privée : modifiable, elle duplique les seules pages
+ * écrites (copie sur écriture) et le fichier reste intact.
+ */
+class FichierSauvegarde
+{
+public:
+    FichierSauvegarde(): adresse(MAP_FAILED), taille(0) {}
+
+    virtual ~FichierSauvegarde() {
+        if (adresse != MAP_FAILED)
+            munmap(adresse, taille);
+    }
+
+    FichierSauvegarde(const FichierSauvegarde &) = delete;
+    FichierSauvegarde & operator=(const FichierSauvegarde &) = delete;
+
+    /**
+     * Projeter une sauvegarde en mémoire et en vérifier l'en-tête
+     * @param nom_fichier Fichier de sauvegarde
+     * @param modifiable Vrai pour calculer directement sur les plans
+     *                   projetés, faux pour les lire une fois
+     */
+    void ouvrir(const std::string & nom_fichier, bool modifiable = false) {
+        const int fd = open(nom_fichier.c_str(), O_RDONLY);
+        struct stat etat;
+
+        if (fd < 0 || fstat(fd, &etat) != 0) {
+            const int erreur = errno;
+
+            if (fd >= 0)
+                close(fd);
+            throw nom_fichier + " - " + std::strerror(erreur);
+        }
+
+        taille = etat.st_size;
+        adresse = taille >= sizeof(EnteteSauvegarde) ?
+            mmap(NULL, taille, modifiable ? PROT_READ | PROT_WRITE : PROT_READ,
+                 MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+
+        if (adresse == MAP_FAILED)
+            throw nom_fichier + " - sauvegarde illisible";
+
+        // Copiés, les plans sont parcourus une seule fois, du début à la fin
+        if (!modifiable)
+            madvise(adresse, taille, MADV_SEQUENTIAL);
+
+        const EnteteSauvegarde & e = entete();
+        const std::size_t points = (std::size_t)e.largeur * e.hauteur;
+
+        if (memcmp(e.signature, SIGNATURE_SAUVEGARDE, sizeof e.signature))
+            throw nom_fichier + " - signature de sauvegarde invalide";
+        if (e.taille_ctc != sizeof(ctc_t))
+            throw nom_fichier + " - plans de " +
+                std::to_string(e.taille_ctc) + " octets par valeur au lieu de "
+                + std::to_string(sizeof(ctc_t));
+        if (taille != sizeof(EnteteSauvegarde) + 3 * points * sizeof(ctc_t))
+            throw nom_fichier + " - sauvegarde tronquée";
+    }
+
+    inline const EnteteSauvegarde & entete() const {
+        return *static_cast<const EnteteSauvegarde *>(adresse);
+    }
+
+    /**
+     * Plans de chaleur (0), de température (1) et de conduction (2)
+     */
+    inline const ctc_t * plan(int p) const {
+        const EnteteSauvegarde & e = entete();
+
+        return reinterpret_cast<const ctc_t *>(
+            static_cast<const char *>(adresse) + sizeof(EnteteSauvegarde)) +
+            p * (std::size_t)e.largeur * e.hauteur;
+    }
+    inline ctc_t * plan(int p) {
+        return const_cast<ctc_t *>(
+            static_cast<const FichierSauvegarde *>(this)->plan(p));
+    }
+
+private:
+    void * adresse;
+    std::size_t taille;
+};
+
+
+/**
+ * Effectuer plusieurs itérations d'un modèle
+ * @param carte Modèle à faire évoluer
+ * @param nb_pas Nombre d'itérations à effectuer
+ * @return La différence de température moyenne de la dernière itération
+ */
+template <class Modele>
+ctc_t avancer(Modele & carte, unsigned int nb_pas)
+{
+    ctc_t delta_temp = 0.;
+
+    for (unsigned int s = 0; s < nb_pas; ++s)
+        delta_temp = carte.un_pas_de_temps();
+
+    return delta_temp;
+}
+
+/**
+ * Faire évoluer un modèle de plusieurs itérations, dont la dernière
+ * accumule ses statistiques pendant son balayage
+ * @param carte Modèle à faire évoluer
+ * @param nb_pas Nombre d'itérations à effectuer
+ * @param stats Statistiques de la dernière itération à compléter
+ * @return La différence de température moyenne de la dernière itération
+ */
+template <class Modele>
+ctc_t avancer(Modele & carte, unsigned int nb_pas, StatistiquesPas & stats)
+{
+    if (nb_pas == 0)
+        return 0.;
+
+    for (unsigned int s = 1; s < nb_pas; ++s)
+        carte.un_pas_de_temps();
+
+    return carte.un_pas_de_temps(stats);
+}
+
+/**
+ * Le modèle en damier effectue ses itérations par tuilage temporel
+ */
+inline ctc_t avancer(ModeleCTCDamier & carte, unsigned int nb_pas)
+{
+    return carte.plusieurs_pas(nb_pas);
+}
+
+inline ctc_t avancer(ModeleCTCDamier & carte, unsigned int nb_pas,
+                     StatistiquesPas & stats)
+{
+    return carte.plusieurs_pas(nb_pas, &stats);
+}
+
+/**
+ * Le modèle sur GPU effectue ses itérations par lots asynchrones
+ */
+inline ctc_t avancer(ModeleCTCGPU & carte, unsigned int nb_pas)
+{
+    return carte.plusieurs_pas(nb_pas);
+}
+
+inline ctc_t avancer(ModeleCTCGPU & carte, unsigned int nb_pas,
+                     StatistiquesPas & stats)
+{
+    return carte.plusieurs_pas(nb_pas, &stats);
+}
+
+
+/**
+ * Préparer un modèle chargé avant la boucle de convergence
+ */
+template <class Modele>
+void preparer(Modele & carte)
+{
+}
+
+inline void preparer(ModeleCTCGPU & carte)
+{
+    carte.transferer_vers_gpu();
+}
+
+inline void preparer(ModeleCTCDamier & carte)
+{
+    carte.preparer();
+}
+
+/**
+ * Rendre les températures d'un modèle accessibles après la convergence
+ */
+template <class Modele>
+void terminer(Modele & carte)
+{
+}
+
+inline void terminer(ModeleCTCGPU & carte)
+{
+    carte.recuperer_temperatures();
+}
+
+/**
+ * Rendre les températures courantes accessibles sur l'hôte en cours de
+ * calcul, pour un instantané
+ */
+template <class Modele>
+void synchroniser(Modele & carte)
+{
+}
+
+inline void synchroniser(ModeleCTCGPU & carte)
+{
+    carte.synchroniser_temperatures();
+}
+
+/**
+ * Reprendre le calcul après une modification des températures sur l'hôte,
+ * par une extrapolation
+ */
+template <class Modele>
+void actualiser(Modele & carte)
+{
+}
+
+inline void actualiser(ModeleCTCGPU & carte)
+{
+    carte.envoyer_temperatures();
+}
+
+inline void actualiser(ModeleCTCDamier & carte)
+{
+    // Les tuiles endormies doivent voir leurs nouvelles températures
+    carte.preparer();
+}
+
+
+/**
+ * Variation d'une itération à comparer au seuil de convergence
+ * @param config Critère de convergence
+ * @param delta_temp Différence de température moyenne de l'itération
+ * @param stats Statistiques de l'itération
+ */
+inline ctc_t variation(const Configuration & config, ctc_t delta_temp,
+                       const StatistiquesPas & stats)
+{
+    return config.critere == CRITERE_MAX ? stats.delta_max : delta_temp;
+}
+
+/**
+ * Seuil de convergence d'un modèle : celui de la configuration, relevé au
+ * bruit de l'arrondi stochastique pour les températures en 16 bits
+ * @param carte Modèle, après sa dernière itération
+ * @param config Seuil et critère de convergence
+ */
+template <class Modele>
+ctc_t seuil_arret(const Modele & carte, const Configuration & config)
+{
+    return config.seuil_convergence;
+}
+
+template <class Stockage>
+ctc_t seuil_arret(const ModeleCTCCompact<Stockage> & carte,
+                  const Configuration & config)
+{
+    return std::max(config.seuil_convergence,
+                    carte.bruit_arrondi(config.critere));
+}
+
+/**
+ * Suivi de la convergence : historique des variations mesurées à la fin des
+ * derniers lots, taux de convergence asymptotique et prévision de la
+ * variation restante. Loin du point fixe, la variation décroît comme
+ * rho^n, où rho est le rayon spectral de l'itération ; le taux est la pente
+ * de log(variation) selon l'itération, par moindres carrés sur la fenêtre.
+ * Il n'est estimé que si la fenêtre est pleine et que les variations y
+ * décroissent toutes.
+ */
+class MoniteurConvergence
+{
+public:
+    explicit MoniteurConvergence(unsigned int fenetre = FENETRE_CONVERGENCE):
+        taille(std::max(fenetre, 3u)), rho(1), nb_extrapolations(0),
+        arret_anticipe(false) {}
+
+    /**
+     * Oublier l'historique, après une extrapolation qui l'interrompt
+     */
+    void reinitialiser() {
+        historique.clear();
+        rho = 1;
+    }
+
+    /**
+     * Ajouter la variation de la dernière itération d'un lot
+     * @param nb_iter Itérations effectuées à la fin du lot
+     * @param ecart Variation comparée au seuil
+     */
+    void ajouter(unsigned int nb_iter, ctc_t ecart) {
+        historique.push_back(std::make_pair(nb_iter, ecart));
+        if (historique.size() > taille)
+            historique.pop_front();
+
+        rho = 1;
+        if (historique.size() < taille)
+            return;
+
+        // Régression de log(ecart) selon l'itération
+        double sn = 0, sl = 0, snn = 0, snl = 0;
+
+        for (std::size_t k = 0; k < historique.size(); ++k) {
+            const double n = historique[k].first;
+            const double e = historique[k].second;
+
+            if (e <= 0 || (k > 0 && e >= historique[k - 1].second))
+                return;
+
+            sn += n;
+            sl += std::log(e);
+            snn += n * n;
+            snl += n * std::log(e);
+        }
+
+        const double m = historique.size();
+        const double denominateur = m * snn - sn * sn;
+
+        if (denominateur > 0) {
+            const double pente = (m * snl - sn * sl) / denominateur;
+
+            if (pente < 0)
+                rho = std::exp(pente);
+        }
+    }
+
+    /**
+     * Vrai si le taux de convergence est estimé
+     */
+    inline bool estime() const { return rho < 1; }
+
+    /**
+     * Taux de convergence par itération, 1 s'il n'est pas estimé
+     */
+    inline double taux() const { return rho; }
+
+    /**
+     * Variation restante prévue jusqu'au point fixe : somme de la série
+     * géométrique des variations des itérations suivantes, infinie si le
+     * taux n'est pas estimé
+     */
+    double restante() const {
+        return estime() ? historique.back().second * rho / (1 - rho) :
+            std::numeric_limits<double>::infinity();
+    }
+
+    /**
+     * Itérations prévues avant que la variation passe sous un seuil
+     */
+    double iterations_restantes(ctc_t seuil) const {
+        if (!estime())
+            return std::numeric_limits<double>::infinity();
+
+        return std::max(0., std::log(seuil / historique.back().second) /
+                        std::log(rho));
+    }
+
+    /**
+     * Lots de la fenêtre d'estimation
+     */
+    inline unsigned int fenetre() const { return taille; }
+
+    /**
+     * Itérations couvertes par l'historique, sur lesquelles le taux est
+     * estimé ; les lots écourtés par les instantanés, les sauvegardes ou la
+     * limite d'itérations y comptent pour ce qu'ils sont
+     */
+    inline unsigned int etendue() const {
+        return historique.empty() ? 0 :
+            historique.back().first - historique.front().first;
+    }
+
+    inline unsigned int extrapolations() const { return nb_extrapolations; }
+    inline void compter_extrapolation() { ++nb_extrapolations; }
+
+    /**
+     * Vrai si la boucle s'est arrêtée sur la prévision plutôt que sur le
+     * seuil ou la limite d'itérations
+     */
+    inline bool anticipe() const { return arret_anticipe; }
+    inline void anticiper() { arret_anticipe = true; }
+
+private:
+    std::deque<std::pair<unsigned int, ctc_t> > historique;
+    unsigned int taille;
+    double rho;
+    unsigned int nb_extrapolations;
+    bool arret_anticipe;
+};
+
+/**
+ * Extrapolation des températures vers le point fixe, par le procédé delta
+ * carré d'Aitken avec le taux de convergence global du moniteur : si l'écart
+ * au point fixe décroît comme rho^n, les températures T0, mémorisées à
+ * l'itération n0, et T, à l'itération n, donnent la limite
+ * T + (T - T0) q / (1 - q), avec q = rho^(n - n0). Un seul plan est
+ * conservé au lieu des deux d'Aitken point par point. Le saut est limité à
+ * FACTEUR_EXTRAPOLATION_MAX fois la variation depuis la mémorisation, et ne
+ * descend jamais sous la chaleur du point, comme l'itération.
+ */
+class ExtrapolationTemperatures
+{
+public:
+    ExtrapolationTemperatures(): iteration(0) {}
+
+    /**
+     * Vrai si des températures sont mémorisées
+     */
+    inline bool memorisees() const { return !anciennes.empty(); }
+
+    /**
+     * Itération des températures mémorisées
+     */
+    inline unsigned int iteration_memorisee() const { return iteration; }
+
+    /**
+     * Mémoriser les températures courantes d'un modèle
+     * @param carte Modèle, synchronisé sur l'hôte
+     * @param nb_iter Itérations effectuées
+     */
+    template <class Modele>
+    void memoriser(const Modele & carte, unsigned int nb_iter) {
+        const std::size_t larg = carte.largeur();
+
+        anciennes.resize(larg * carte.hauteur());
+        for (std::size_t i = 0; i < carte.hauteur(); ++i) {
+            for (std::size_t j = 0; j < larg; ++j)
+                anciennes[i * larg + j] = carte.temperature(i, j);
+        }
+        iteration = nb_iter;
+    }
+
+    /**
+     * Remplacer les températures d'un modèle par leur limite extrapolée,
+     * puis oublier les températures mémorisées
+     * @param carte Modèle, synchronisé sur l'hôte
+     * @param nb_iter Itérations effectuées
+     * @param rho Taux de convergence par itération, dans ]0, 1[
+     */
+    template <class Modele>
+    void extrapoler(Modele & carte, unsigned int nb_iter, double rho) {
+        const double q = std::pow(rho, (double)(nb_iter - iteration));
+        const ctc_t facteur = std::min(q / (1 - q), FACTEUR_EXTRAPOLATION_MAX);
+        const std::size_t larg = carte.largeur();
+
+        for (std::size_t i = 0; i < carte.hauteur(); ++i) {
+            for (std::size_t j = 0; j < larg; ++j) {
+                CTC point = carte.ctc(i, j);
+
+                if (point.conduction > 0) {
+                    point.temperature = std::max(point.chaleur,
+                        point.temperature + facteur *
+                        (point.temperature - anciennes[i * larg + j]));
+                    carte.ctc(i, j) = point;
+                }
+            }
+        }
+
+        anciennes.clear();
+    }
+
+private:
+    std::vector<ctc_t> anciennes;
+    unsigned int iteration;
+};
+
+/**
+ * Itérer un modèle jusqu'à la convergence ou la limite d'itérations. La
+ * dernière itération d'un lot accumule ses statistiques si le critère
+ * CRITERE_MAX en a besoin, pour un instantané, ou si le lot peut être le
+ * dernier : l'appelant n'a alors pas à reparcourir la grille. Ailleurs,
+ * elles ralentiraient le balayage sans servir.
+ *
+ * Avec config.tolerance_restante, la boucle s'arrête aussi dès que la
+ * variation restante prévue par le moniteur passe sous cette tolérance.
+ * Avec config.extrapolation, les températures sont mémorisées dès que le
+ * taux est estimé, puis extrapolées une fenêtre de lots plus tard. La
+ * convergence n'est pas acceptée pendant la fenêtre qui suit un saut, dont
+ * les variations peuvent être négatives ou anormalement faibles.
+ * @param carte Modèle à faire converger
+ * @param config Seuil et critère de convergence, limite et taille des blocs
+ * @param delta_temp Différence de température moyenne de la dernière
+ *                   itération ; à la reprise d'une sauvegarde, celle de
+ *                   la sauvegarde
+ * @param nb_iter Itérations déjà effectuées, à la reprise d'une sauvegarde
+ * @param ecrivain Destinataire des instantanés, toutes les
+ *                 config.instantanes itérations, ou NULL
+ * @param stats Statistiques de la dernière itération, invalides si elle
+ *              ne les a pas accumulées, ou NULL
+ * @param suivi Moniteur recevant l'historique des variations, ou NULL
+ * @return Le nombre d'itérations effectuées, reprise incluse
+ */
+template <class Modele>
+unsigned int converger(Modele & carte, const Configuration & config,
+                       ctc_t & delta_temp, unsigned int nb_iter = 0,
+                       EcrivainInstantanes * ecrivain = NULL,
+                       StatistiquesPas * stats = NULL,
+                       MoniteurConvergence * suivi = NULL)
+{
+    const bool sauvegardes =
+        !config.sauvegarde.empty() && config.periode_sauvegarde > 0;
+    const bool surveiller =
+        config.tolerance_restante > 0 || config.extrapolation;
+    MoniteurConvergence moniteur_local(config.fenetre);
+    MoniteurConvergence & moniteur =
+        suivi != NULL ? *suivi : moniteur_local;
+    ExtrapolationTemperatures extrapolation;
+    unsigned int garde = nb_iter;  // Convergence refusée avant
+    StatistiquesPas lot;
+
+    if (nb_iter == 0)
+        delta_temp = config.seuil_convergence + 1.;
+
+    // La sauvegarde ne garde que l'ajustement moyen
+    ctc_t ecart = (nb_iter == 0 || config.critere == CRITERE_MAX) ?
+        config.seuil_convergence + 1. : delta_temp;
+
+    while ((ecart > seuil_arret(carte, config) || nb_iter < garde) &&
+           nb_iter < config.nb_max_iter) {
+        unsigned int nb_pas =
+            std::min(config.bloc, config.nb_max_iter - nb_iter);
+
+        // Les lots s'arrêtent sur les itérations des instantanés et des
+        // sauvegardes
+        if (ecrivain != NULL) {
+            nb_pas = std::min(nb_pas,
+                config.instantanes - nb_iter % config.instantanes);
+        }
+        if (sauvegardes) {
+            nb_pas = std::min(nb_pas, config.periode_sauvegarde -
+                nb_iter % config.periode_sauvegarde);
+        }
+
+        const bool mesurer = config.critere == CRITERE_MAX ||
+            nb_iter + nb_pas == config.nb_max_iter ||
+            ecart < APPROCHE_CONVERGENCE * seuil_arret(carte, config) ||
+            (ecrivain != NULL &&
+             (nb_iter + nb_pas) % config.instantanes == 0);
+
+        lot = StatistiquesPas();
+        delta_temp = mesurer ? avancer(carte, nb_pas, lot) :
+            avancer(carte, nb_pas);
+        ecart = variation(config, delta_temp, lot);
+        nb_iter += nb_pas;
+
+        if (ecrivain != NULL && nb_iter % config.instantanes == 0) {
+            synchroniser(carte);
+            ecrivain->capturer(carte, nb_iter, &lot);
+        }
+        if (sauvegardes && nb_iter % config.periode_sauvegarde == 0) {
+            synchroniser(carte);
+            sauvegarder(carte, config, nb_iter, delta_temp);
+        }
+
+        if (!surveiller)
+            continue;
+
+        moniteur.ajouter(nb_iter, ecart);
+        if (nb_iter >= garde && config.tolerance_restante > 0 &&
+            ecart > seuil_arret(carte, config) &&
+            moniteur.restante() < config.tolerance_restante) {
+            moniteur.anticiper();
+            break;
+        }
+
+        // Mémoriser dès que le taux est estimé, extrapoler une fenêtre de
+        // lots plus tard si la convergence est restée géométrique
+        if (config.extrapolation && moniteur.estime() &&
+            nb_iter < config.nb_max_iter) {
+            const unsigned int nb_pas_fenetre = moniteur.etendue();
+
+            if (!extrapolation.memorisees()) {
+                synchroniser(carte);
+                extrapolation.memoriser(carte, nb_iter);
+            }
+            else if (nb_iter - extrapolation.iteration_memorisee() >=
+                     nb_pas_fenetre) {
+                synchroniser(carte);
+                extrapolation.extrapoler(carte, nb_iter, moniteur.taux());
+                actualiser(carte);
+                moniteur.reinitialiser();
+                moniteur.compter_extrapolation();
+                garde = nb_iter + nb_pas_fenetre;
+            }
+        }
+        else if (extrapolation.memorisees() && !moniteur.estime()) {
+            // Convergence devenue irrégulière : recommencer la mémorisation
+            extrapolation = ExtrapolationTemperatures();
+        }
+    }
+
+    if (stats != NULL)
+        *stats = lot;
+
+    return nb_iter;
+}
+
+
+/**
+ * Restreindre une grille à la demi-résolution : chaque point grossier
+ * représente un bloc de 2x2 points fins. La chaleur est le maximum du bloc,
+ * pour ne pas diluer les sources, et la conduction en est le minimum, pour
+ * que les murs de conduction nulle d'un seul point ne disparaissent pas.
+ * La température est la moyenne du bloc.
+ * @param fin Modèle à restreindre
+ * @param grossier Modèle grossier à remplir
+ */
+template <class Modele>
+void restreindre(const Modele & fin, ModeleCTC & grossier)
+{
+    const std::size_t larg = fin.largeur();
+    const std::size_t haut = fin.hauteur();
+
+    grossier.redimensionner((larg + 1) / 2, (haut + 1) / 2);
+
+    for (std::size_t i = 0; i < grossier.hauteur(); ++i) {
+        for (std::size_t j = 0; j < grossier.largeur(); ++j) {
+            ctc_t chaleur = 0.;
+            ctc_t temperature = 0.;
+            ctc_t conduction = 0.;
+            unsigned int nb = 0;
+
+            for (std::size_t di = 0; di < 2 && 2 * i + di < haut; ++di) {
+                for (std::size_t dj = 0; dj < 2 && 2 * j + dj < larg; ++dj) {
+                    const CTC point = fin.ctc(2 * i + di, 2 * j + dj);
+
+                    chaleur = std::max(chaleur, point.chaleur);
+                    temperature += point.temperature;
+                    conduction = nb == 0 ? point.conduction :
+                        std::min(conduction, point.conduction);
+                    ++nb;
+                }
+            }
+
+            grossier.ctc(i, j) = CTC {
+                chaleur, temperature / nb, conduction
+            };
+        }
+    }
+}
+
+/**
+ * Prolonger les températures d'une grille grossière vers la grille fine,
+ * par injection dans chaque bloc de 2x2 points. La marge d'un point, que
+ * le solveur ne met jamais à jour, fixe les températures aux bords : elle
+ * garde ses valeurs, tout comme les points sans conduction.
+ * @param grossier Modèle grossier convergé
+ * @param fin Modèle dont les températures initiales sont remplacées
+ */
+template <class Modele>
+void prolonger(const ModeleCTC & grossier, Modele & fin)
+{
+    for (std::size_t i = 1; i + 1 < fin.hauteur(); ++i) {
+        for (std::size_t j = 1; j + 1 < fin.largeur(); ++j) {
+            CTC point = fin.ctc(i, j);
+
+            if (point.conduction > 0) {
+                point.temperature = grossier.temperature(i / 2, j / 2);
+                fin.ctc(i, j) = point;
+            }
+        }
+    }
+}
+
+#ifdef DEBUG
+/**
+ * Températures de la marge d'un point, que le solveur ne met jamais à jour.
+ * Sert à vérifier que l'initialisation multigrille ne la modifie pas.
+ */
+template <class Modele>
+std::vector<ctc_t> temperatures_marge(Modele & carte)
+{
+    std::vector<ctc_t> marge;
+    const std::size_t haut = carte.hauteur();
+    const std::size_t larg = carte.largeur();
+
+    for (std::size_t i = 0; i < haut; ++i) {
+        // Rangées extrêmes en entier, sinon les deux colonnes extrêmes
+        const std::size_t pas = i == 0 || i + 1 == haut ? 1 : larg - 1;
+
+        for (std::size_t j = 0; j < larg; j += pas) {
+            const CTC point = carte.ctc(i, j);
+            marge.push_back(point.temperature);
+        }
+    }
+
+    return marge;
+}
+#endif
+
+/**
+ * Afficher les itérations et le temps de calcul d'un niveau de grille
+ */
+inline void rapporter_niveau(unsigned int niveau,
+                             std::size_t larg, std::size_t haut,
+                             unsigned int nb_iter, double secondes,
+                             std::ostream & journal = std::cout)
+{
+    journal << "Niveau " << niveau << " (" << larg << "x" << haut << ")"
+        << " : " << nb_iter << " itérations, " << secondes << " s"
+        << std::endl;
+}
+
+/**
+ * Initialiser les températures d'un modèle par itérations emboîtées :
+ * le problème est d'abord résolu sur des grilles grossières, de la plus
+ * grossière à la plus fine, et chaque solution sert de température initiale
+ * au niveau suivant. La chaleur s'y propage sur de grandes distances en peu
+ * d'itérations, et la grille fine n'a plus qu'à corriger les détails.
+ * Les marges et les points sans conduction gardent leurs températures,
+ * si bien que le point fixe de la grille fine est inchangé.
+ * @param carte Modèle à la pleine résolution
+ * @param config Configuration du modèle, dont le nombre de niveaux grossiers
+ * @param journal Flux recevant le rapport de chaque niveau
+ */
+template <class Modele>
+void multigrille(Modele & carte, const Configuration & config,
+                 std::ostream & journal = std::cout)
+{
+    unsigned int nb_niveaux = config.nb_niveaux;
+    std::vector<ModeleCTC> niveaux(nb_niveaux);
+    Configuration config_niveau(config);
+    Configuration config_grossier(config);
+
+    // Les sauvegardes ne concernent que la pleine résolution
+    config_grossier.sauvegarde.clear();
+
+#ifdef DEBUG
+    const std::vector<ctc_t> marge = temperatures_marge(carte);
+#endif
+
+    for (unsigned int n = 0; n < nb_niveaux; ++n) {
+        // Une grille sans points intérieurs n'a plus rien à résoudre
+        const std::size_t larg = n == 0 ? carte.largeur() :
+            niveaux[n - 1].largeur();
+        const std::size_t haut = n == 0 ? carte.hauteur() :
+            niveaux[n - 1].hauteur();
+
+        if (larg < 6 || haut < 6) {
+            nb_niveaux = n;
+            niveaux.resize(n);
+            break;
+        }
+
+        if (n == 0)
+            restreindre(carte, niveaux[n]);
+        else
+            restreindre(niveaux[n - 1], niveaux[n]);
+
+        // Le bruit est une source par point : à pas double, il quadruple
+        // pour donner la même accumulation de chaleur par unité de surface
+        config_niveau.bruit *= 4;
+        niveaux[n].configurer(config_niveau);
+    }
+
+    for (unsigned int n = nb_niveaux; n-- > 0; ) {
+        const auto debut = std::chrono::steady_clock::now();
+        ctc_t delta_temp;
+
+        if (n + 1 < nb_niveaux)
+            prolonger(niveaux[n + 1], niveaux[n]);
+
+        const unsigned int nb_iter =
+            converger(niveaux[n], config_grossier, delta_temp);
+
+        rapporter_niveau(n + 1, niveaux[n].largeur(), niveaux[n].hauteur(),
+                         nb_iter, secondes_depuis(debut), journal);
+    }
+
+    if (nb_niveaux > 0)
+        prolonger(niveaux[0], carte);
+}
+
+
+/**
+ * Copier des plans complets de chaleur, de température et de conduction
+ * dans un modèle déjà dimensionné. Les dispositions en triplets ou en
+ * valeurs compactes les convertissent point par point ; le damier et les
+ * plans de l'accélérateur les copient en bloc. La reprise du modèle en
+ * plans calcule plutôt sur la projection (voir simuler).
+ */
+template <class Modele>
+void copier_plans(Modele & carte, const ctc_t * chaleur,
+                  const ctc_t * temperature, const ctc_t * conduction)
+{
+    const std::size_t points = carte.largeur() * carte.hauteur();
+    auto point = carte.begin();
+
+    for (std::size_t k = 0; k < points; ++k, ++point)
+        *point = CTC { chaleur[k], temperature[k], conduction[k] };
+}
+
+inline void copier_plans(ModeleCTCPlans & carte, const ctc_t * chaleur,
+                         const ctc_t * temperature, const ctc_t * conduction)
+{
+    carte.copier_plans(chaleur, temperature, conduction);
+}
+
+inline void copier_plans(ModeleCTCGPU & carte, const ctc_t * chaleur,
+                         const ctc_t * temperature, const ctc_t * conduction)
+{
+    carte.copier_plans(chaleur, temperature, conduction);
+}
+
+inline void copier_plans(ModeleCTCDamier & carte, const ctc_t * chaleur,
+                         const ctc_t * temperature, const ctc_t * conduction)
+{
+    carte.copier_plans(chaleur, temperature, conduction);
+}
+
+
+/**
+ * Avertir si le bruit ou le seuil diffèrent de ceux d'une sauvegarde
+ */
+inline void comparer_parametres(const EnteteSauvegarde & entete,
+                                const Configuration & config)
+{
+    if ((ctc_t)entete.bruit != config.bruit ||
+        (ctc_t)entete.seuil_convergence != config.seuil_convergence) {
+        std::cerr << "Avertissement: bruit ou seuil différent de la "
+            << "sauvegarde (" << entete.bruit * 256 << ", "
+            << entete.seuil_convergence * 256 << ")" << std::endl;
+    }
+}
+
+/**
+ * Remplir un modèle depuis une sauvegarde projetée en mémoire
+ * @param nom_fichier Fichier de sauvegarde
+ * @param carte Modèle à redimensionner et remplir
+ * @param config Paramètres du calcul, comparés à ceux de la sauvegarde
+ * @param delta_temp Ajustement moyen de la dernière itération sauvegardée
+ * @param rapport Mesures recevant les durées de lecture et de conversion,
+ *                ou NULL
+ * @return Le nombre d'itérations déjà effectuées
+ */
+template <class Modele>
+unsigned int reprendre(const std::string & nom_fichier, Modele & carte,
+                       const Configuration & config, ctc_t & delta_temp,
+                       RapportCalcul * rapport = NULL)
+{
+    auto instant = std::chrono::steady_clock::now();
+    FichierSauvegarde reprise;
+
+    reprise.ouvrir(nom_fichier);
+
+    const EnteteSauvegarde & entete = reprise.entete();
+    const ctc_t * chaleur = reprise.plan(0);
+    const ctc_t * temperature = reprise.plan(1);
+    const ctc_t * conduction = reprise.plan(2);
+
+    comparer_parametres(entete, config);
+
+    if (rapport != NULL) {
+        rapport->secondes[PHASE_LECTURE] += secondes_depuis(instant);
+        instant = std::chrono::steady_clock::now();
+    }
+
+    // Les pages projetées sont lues ici, au fil de la copie
+    carte.redimensionner(entete.largeur, entete.hauteur);
+    copier_plans(carte, chaleur, temperature, conduction);
+
+    if (rapport != NULL)
+        rapport->secondes[PHASE_CONVERSION] += secondes_depuis(instant);
+
+    delta_temp = entete.delta_temp;
+    return entete.nb_iter;
+}
+
+
+/**
+ * Triplet CTC d'un pixel RGB des conditions initiales
+ */
+inline CTC pixel_vers_ctc(const png_color & pixel)
+{
+    return CTC {
+        (ctc_t)pixel.red,
+        (ctc_t)pixel.green,
+        (ctc_t)pixel.blue / 256
+    };
+}
+
+/**
+ * Remplir un modèle depuis une image PNG, rangée par rangée : aucune image
+ * complète ne coexiste avec le modèle. Les images que LecteurPNG ne lit
+ * pas ainsi (palette, gris, alpha, entrelacement) sont décodées en entier
+ * par LePNG, qui est libéré dès la conversion terminée.
+ * @param nom_fichier Image PNG des conditions initiales
+ * @param carte Modèle à redimensionner et remplir
+ * @param rapport Mesures recevant les durées de lecture et de conversion,
+ *                ou NULL
+ */
+template <class Modele>
+void charger(const std::string & nom_fichier, Modele & carte,
+             RapportCalcul * rapport = NULL)
+{
+    auto instant = std::chrono::steady_clock::now();
+    double lecture = 0.;
+    double conversion = 0.;
+    LecteurPNG lecteur;
+
+    if (lecteur.ouvrir(nom_fichier)) {
+        std::vector<png_color> rangee(lecteur.largeur());
+
+        carte.redimensionner(lecteur.largeur(), lecteur.hauteur());
+
+        auto point = carte.begin();
+
+        for (png_uint_32 i = 0; i < lecteur.hauteur(); ++i) {
+            lecteur.lire_rangee(rangee.data());
+            lecture += secondes_depuis(instant);
+            instant = std::chrono::steady_clock::now();
+
+            point = std::transform(rangee.cbegin(), rangee.cend(), point,
+                                   pixel_vers_ctc);
+            conversion += secondes_depuis(instant);
+            instant = std::chrono::steady_clock::now();
+        }
+    }
+    else {
+        LePNG png;
+
+        png.charger(nom_fichier);
+        lecture = secondes_depuis(instant);
+        instant = std::chrono::steady_clock::now();
+
+        carte.redimensionner(png.largeur(), png.hauteur());
+        std::transform(png.cbegin(), png.cend(), carte.begin(),
+                       pixel_vers_ctc);
+        conversion = secondes_depuis(instant);
+    }
+
+    if (rapport != NULL) {
+        rapport->secondes[PHASE_LECTURE] += lecture;
+        rapport->secondes[PHASE_CONVERSION] += conversion;
+    }
+}
+
+
+/**
+ * Octets qu'une mise à jour d'un point échange au minimum avec la mémoire :
+ * chaleur, conduction et température lues, température écrite, les
+ * températures voisines étant supposées dans la cache
+ */
+template <class Modele>
+std::size_t octets_par_point(const Modele & carte)
+{
+    return 4 * sizeof(ctc_t);
+}
+
+template <class Stockage>
+std::size_t octets_par_point(const ModeleCTCCompact<Stockage> & carte)
+{
+    return 2 * sizeof(std::uint8_t) + 2 * sizeof(Stockage);
+}
+
+
+/**
+ * Faire converger un modèle chargé et enregistrer le résultat
+ *
+ * @param nom_resultat Image PNG des températures obtenues
+ * @param carte_gpu Modèle rempli par l'image ou par une sauvegarde
+ * @param config Paramètres d'exécution du solveur
+ * @param nb_iter Itérations déjà effectuées (sauvegarde), sinon 0
+ * @param delta_temp Ajustement moyen de la dernière itération effectuée
+ * @param mesures Mesures du calcul, déjà remplies par le chargement
+ * @param journal Flux recevant les statistiques du calcul
+ * @return Code de sortie du programme
+ */
+template <class Modele>
+int resoudre(const std::string & nom_resultat, Modele & carte_gpu,
+             const Configuration & config, unsigned int nb_iter,
+             ctc_t delta_temp, RapportCalcul & mesures,
+             std::ostream & journal)
+{
+    StatistiquesPas stats;
+
+    // Ouverts avant la première région OpenMP du calcul, pour la compter
+    CompteursMateriels compteurs;
+    const bool avec_compteurs = config.compteurs && compteurs.ouvrir();
+
+    if (config.compteurs && !avec_compteurs) {
+        std::cerr << "Avertissement: compteurs matériels indisponibles "
+            << "(perf_event_open)" << std::endl;
+    }
+
+    // Températures initiales par grilles grossières, sauf à la reprise
+    const auto debut = std::chrono::steady_clock::now();
+
+    carte_gpu.configurer(config);
+    if (config.reprise.empty())
+        multigrille(carte_gpu, config, journal);
+
+    // Boucle principale
+    const auto debut_fin = std::chrono::steady_clock::now();
+    const unsigned int nb_iter_depart = nb_iter;
+
+    mesures.secondes[PHASE_MULTIGRILLE] = secondes_depuis(debut);
+
+    MoniteurConvergence moniteur(config.fenetre);
+
+    if (avec_compteurs)
+        compteurs.demarrer();
+    preparer(carte_gpu);
+    if (config.instantanes > 0) {
+        // Le destructeur attend l'écriture des derniers instantanés
+        EcrivainInstantanes ecrivain(carte_gpu.largeur(), carte_gpu.hauteur(),
+                                     config.motif_instantanes);
+
+        nb_iter = converger(carte_gpu, config, delta_temp, nb_iter,
+                            &ecrivain, &stats, &moniteur);
+    }
+    else {
+        nb_iter = converger(carte_gpu, config, delta_temp, nb_iter, NULL,
+                            &stats, &moniteur);
+    }
+    terminer(carte_gpu);
+    if (avec_compteurs) {
+        compteurs.arreter();
+        mesures.compteurs_lus = compteurs.lire(mesures.compteurs);
+    }
+
+    // Sauvegarde finale, si la dernière itération n'en a pas déjà fait une
+    if (!config.sauvegarde.empty() && (config.periode_sauvegarde == 0 ||
+                                       nb_iter % config.periode_sauvegarde)) {
+        sauvegarder(carte_gpu, config, nb_iter, delta_temp);
+    }
+
+    mesures.secondes[PHASE_CONVERGENCE] = secondes_depuis(debut_fin);
+
+    if (config.nb_niveaux > 0) {
+        rapporter_niveau(0, carte_gpu.largeur(), carte_gpu.hauteur(),
+                         nb_iter, secondes_depuis(debut_fin), journal);
+        journal << "Temps total : " << secondes_depuis(debut) << " s"
+            << std::endl;
+    }
+
+    // Calcul et affichage de statistiques : les extrêmes viennent de la
+    // dernière itération, si elle les a accumulés
+    const auto debut_minmax = std::chrono::steady_clock::now();
+    const bool mesurees = stats.valides();
+
+    if (!mesurees) {
+        const auto minmax = std::minmax_element(
+            carte_gpu.cbegin(), carte_gpu.cend(),
+            [](const CTC & a, const CTC & b) {
+                return a.temperature < b.temperature;
+            });
+
+        stats.t_min = minmax.first->temperature;
+        stats.t_max = minmax.second->temperature;
+    }
+
+    const ctc_t t_min = stats.t_min;
+    const ctc_t t_max = stats.t_max;
+
+    mesures.secondes[PHASE_MINMAX] = secondes_depuis(debut_minmax);
+    journal << "Itération #" << nb_iter
+        << ", ajustement moyen = " << delta_temp * 256 << " / 256";
+    if (config.critere == CRITERE_MAX && mesurees)
+        journal << ", ajustement max = " << stats.delta_max * 256 << " / 256";
+    if (moniteur.extrapolations() > 0)
+        journal << ", " << moniteur.extrapolations() << " extrapolation(s)";
+    if (moniteur.anticipe()) {
+        journal << ", arrêt anticipé (reste prévu = "
+            << moniteur.restante() * 256 << " / 256)";
+    }
+    journal << ", t_min = " << t_min
+        << ", t_max = " << t_max
+        << std::endl;
+
+    mesures.largeur = carte_gpu.largeur();
+    mesures.hauteur = carte_gpu.hauteur();
+    mesures.nb_iter = nb_iter;
+    mesures.nb_iter_calculees = nb_iter - nb_iter_depart;
+    mesures.delta_temp = delta_temp;
+    mesures.t_min = t_min;
+    mesures.t_max = t_max;
+    mesures.taux_convergence = moniteur.taux();
+    mesures.arret_anticipe = moniteur.anticipe();
+    mesures.nb_extrapolations = moniteur.extrapolations();
+    mesures.octets_par_point = octets_par_point(carte_gpu);
+
+    int code = 0;
+
+    try {
+        // Enregistrer les températures en pixels RGB, par bandes
+        PaletteCouleurs palette;
+        EcrivainPNG sortie;
+
+        palette.etalonner(t_min, t_max);
+        sortie.ouvrir(nom_resultat, carte_gpu.largeur(), carte_gpu.hauteur());
+        palette.exporter(carte_gpu, sortie, &mesures);
+
+        const auto debut_fermeture = std::chrono::steady_clock::now();
+
+        sortie.fermer();
+        mesures.secondes[PHASE_ECRITURE] += secondes_depuis(debut_fermeture);
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        code = 3;
+    }
+
+    return code;
+}
+
+/**
+ * Charger l'image, faire converger le modèle et enregistrer le résultat
+ *
+ * @param nom_fichier Image PNG des conditions initiales
+ * @param nom_resultat Image PNG des températures obtenues
+ * @param carte_gpu Modèle à utiliser (ModeleCTC, ModeleCTCPlans, etc.)
+ * @param config Paramètres d'exécution du solveur ; avec config.reprise,
+ *               le modèle est rempli par la sauvegarde et non par l'image
+ * @param journal Flux recevant les statistiques du calcul
+ * @param rapport Mesures du calcul à remplir (durée des phases, débit,
+ *                compteurs matériels avec config.compteurs), ou NULL
+ * @return Code de sortie du programme
+ */
+template <class Modele>
+int simuler(const std::string & nom_fichier, const std::string & nom_resultat,
+            Modele & carte_gpu, const Configuration & config,
+            std::ostream & journal = std::cout,
+            RapportCalcul * rapport = NULL)
+{
+    RapportCalcul mesures;
+    unsigned int nb_iter = 0;
+    ctc_t delta_temp;
+
+    try {
+        if (!config.reprise.empty()) {
+            // Reprendre le calcul là où la sauvegarde l'a laissé
+            nb_iter = reprendre(config.reprise, carte_gpu, config,
+                                delta_temp, &mesures);
+        }
+        else
+            charger(nom_fichier, carte_gpu, &mesures);
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 2;
+    }
+
+    const int code = resoudre(nom_resultat, carte_gpu, config, nb_iter,
+                              delta_temp, mesures, journal);
+
+    if (rapport != NULL)
+        *rapport = mesures;
+
+    return code;
+}
+
+/**
+ * Simuler avec le modèle en plans. Les plans d'une sauvegarde ont déjà sa
+ * disposition : à la reprise, le calcul se fait sans copie sur une vue
+ * (ModeleCTCVue) de la projection privée du fichier, dont seules les pages
+ * de températures modifiées sont dupliquées.
+ */
+inline int simuler(const std::string & nom_fichier,
+                   const std::string & nom_resultat,
+                   ModeleCTCPlans & carte_gpu, const Configuration & config,
+                   std::ostream & journal = std::cout,
+                   RapportCalcul * rapport = NULL)
+{
+    if (config.reprise.empty()) {
+        return simuler<ModeleCTCPlans>(nom_fichier, nom_resultat, carte_gpu,
+                                       config, journal, rapport);
+    }
+
+    const auto debut = std::chrono::steady_clock::now();
+    RapportCalcul mesures;
+    FichierSauvegarde reprise;
+
+    try {
+        reprise.ouvrir(config.reprise, true);
+    }
+    catch (const std::string message) {
+        std::cerr << "Erreur: " << message << std::endl;
+        return 2;
+    }
+
+    const EnteteSauvegarde & entete = reprise.entete();
+    ModeleCTCVue carte(reprise.plan(0), reprise.plan(1), reprise.plan(2),
+                       entete.largeur, entete.hauteur);
+
+    comparer_parametres(entete, config);
+    mesures.secondes[PHASE_LECTURE] += secondes_depuis(debut);
+
+    const int code = resoudre(nom_resultat, carte, config, entete.nb_iter,
+                              (ctc_t)entete.delta_temp, mesures, journal);
+
+    if (rapport != NULL)
+        *rapport = mesures;
+
+    return code;
+}
+
+
+/**
+ * Solveur intégrable, sans fichier : il fait évoluer une grille en
+ * mémoire (ModeleCTCVue sur les plans de l'appelant), pas à pas ou jusqu'à
+ * la convergence, en rendant compte de sa progression par un rappel.
+ */
+class SolveurCTC
+{
+public:
+    /**
+     * Rappel de progression, appelé toutes les config.bloc itérations
+     * @param nb_iter Itérations effectuées
+     * @param delta_temp Ajustement moyen de la dernière itération
+     * @param donnee Pointeur transmis tel quel par l'appelant
+     * @return Faux pour interrompre la convergence
+     */
+    typedef bool (*Progression)(unsigned int nb_iter, ctc_t delta_temp,
+                                void * donnee);
+
+    /**
+     * @param chaleur Plan de chaleur, largeur x hauteur valeurs
+     * @param temperature Plan de température, mis à jour sur place
+     * @param conduction Plan de conduction
+     * @param largeur Largeur de la grille, marge de 1 pixel incluse
+     * @param hauteur Hauteur de la grille, marge de 1 pixel incluse
+     * @param config Paramètres d'exécution du solveur
+     */
+    SolveurCTC(ctc_t * chaleur, ctc_t * temperature, ctc_t * conduction,
+               std::size_t largeur, std::size_t hauteur,
+               const Configuration & config = Configuration()):
+        carte(chaleur, temperature, conduction, largeur, hauteur),
+        nb_iter(0), delta_temp(std::numeric_limits<ctc_t>::max()),
+        ecart(std::numeric_limits<ctc_t>::max()) {
+        configurer(config);
+    }
+
+    /**
+     * Changer les paramètres d'exécution entre deux appels
+     */
+    void configurer(const Configuration & config) {
+        parametres = config;
+        carte.configurer(config);
+        moniteur = MoniteurConvergence(config.fenetre);
+    }
+
+    /**
+     * Effectuer un nombre d'itérations donné, sans test de convergence
+     * @return La différence de température moyenne de la dernière itération
+     */
+    ctc_t avancer(unsigned int nb_pas) {
+        if (nb_pas > 0 && parametres.critere == CRITERE_MAX) {
+            StatistiquesPas stats;
+
+            delta_temp = ::avancer(carte, nb_pas, stats);
+            ecart = stats.delta_max;
+            nb_iter += nb_pas;
+        }
+        else if (nb_pas > 0) {
+            delta_temp = ecart = ::avancer(carte, nb_pas);
+            nb_iter += nb_pas;
+        }
+
+        return delta_temp;
+    }
+
+    /**
+     * Itérer jusqu'à la convergence, la limite d'itérations ou
+     * l'interruption par le rappel. Avec config.tolerance_restante, la
+     * boucle s'arrête aussi sur la variation restante prévue ; les
+     * températures de l'appelant ne sont jamais extrapolées.
+     * @param rappel Rappel de progression, ou NULL
+     * @param donnee Pointeur transmis au rappel
+     * @return Le nombre total d'itérations effectuées
+     */
+    unsigned int converger(Progression rappel = NULL, void * donnee = NULL) {
+        while (ecart > parametres.seuil_convergence &&
+               nb_iter < parametres.nb_max_iter) {
+            avancer(std::min(parametres.bloc,
+                             parametres.nb_max_iter - nb_iter));
+
+            if (parametres.tolerance_restante > 0) {
+                moniteur.ajouter(nb_iter, ecart);
+                if (ecart > parametres.seuil_convergence &&
+                    moniteur.restante() < parametres.tolerance_restante) {
+                    moniteur.anticiper();
+                    break;
+                }
+            }
+
+            if (rappel != NULL && !rappel(nb_iter, delta_temp, donnee))
+                break;
+        }
+
+        return nb_iter;
+    }
+
+    inline unsigned int nb_iterations() const { return nb_iter; }
+    inline ctc_t ajustement() const { return delta_temp; }
+    inline const ModeleCTCVue & modele() const { return carte; }
+    inline const MoniteurConvergence & suivi() const { return moniteur; }
+
+private:
+    ModeleCTCVue carte;
+    Configuration parametres;
+    unsigned int nb_iter;
+    ctc_t delta_temp;  // Ajustement moyen de la dernière itération
+    ctc_t ecart;       // Variation comparée au seuil (config.critere) ;
+                       // maximale avant la première itération, quel que
+                       // soit le seuil donné ensuite à configurer()
+    MoniteurConvergence moniteur;
+};
+
+#endif  // ECOULEMENT_H
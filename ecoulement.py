@@ -0,0 +1,152 @@
+"""
+Liaison Python de libecoulement (make bibliotheque), par ctypes
+
+Le solveur travaille directement sur les plans fournis, sans copie : tout
+objet à tampon inscriptible de valeurs float32 contiguës convient
+(numpy.ndarray de dtype float32, array.array('f'), etc.). Les températures
+y sont mises à jour sur place.
+
+    import numpy as np
+    import ecoulement
+
+    hauteur, largeur = 64, 128
+    chaleur = np.zeros((hauteur, largeur), dtype=np.float32)
+    chaleur[hauteur // 2, largeur // 2] = 255  # Source au centre
+    temperature = np.full((hauteur, largeur), 20, dtype=np.float32)
+    conduction = np.full((hauteur, largeur), 0.5, dtype=np.float32)
+
+    solveur = ecoulement.Solveur(chaleur, temperature, conduction,
+                                 largeur, hauteur)
+    solveur.converger(lambda nb_iter, delta: print(nb_iter, delta * 256))
+    print(temperature.min(), temperature.max())
+"""
+
+import ctypes
+import os
+
+
+ctc_t = ctypes.c_float
+BRUIT = 6.4 / 256  # 6.4 unités de la résolution de 8 bits
+SEUIL_CONVERGENCE = 0.5 / 256  # 0.5 unité par pixel
+NB_MAX_ITER = 5000  # Limiter le temps de calcul
+
+_PROGRESSION = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_uint, ctc_t,
+                                ctypes.c_void_p)
+
+
+def _charger_bibliotheque():
+    """
+    Charger libecoulement.so, désignée par ECOULEMENT_BIBLIOTHEQUE ou
+    placée à côté de ce module
+    """
+
+    chemin = os.environ.get(
+        "ECOULEMENT_BIBLIOTHEQUE",
+        os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                     "libecoulement.so"))
+    bib = ctypes.CDLL(chemin)
+
+    plan = ctypes.POINTER(ctc_t)
+    solveur = ctypes.c_void_p
+
+    bib.ecoulement_creer.argtypes = [plan, plan, plan,
+                                     ctypes.c_size_t, ctypes.c_size_t]
+    bib.ecoulement_creer.restype = solveur
+    bib.ecoulement_configurer.argtypes = [solveur, ctypes.c_double,
+                                          ctypes.c_double, ctypes.c_uint,
+                                          ctypes.c_uint]
+    bib.ecoulement_configurer.restype = None
+    bib.ecoulement_avancer.argtypes = [solveur, ctypes.c_uint]
+    bib.ecoulement_avancer.restype = ctc_t
+    bib.ecoulement_converger.argtypes = [solveur, _PROGRESSION,
+                                         ctypes.c_void_p]
+    bib.ecoulement_converger.restype = ctypes.c_uint
+    bib.ecoulement_iterations.argtypes = [solveur]
+    bib.ecoulement_iterations.restype = ctypes.c_uint
+    bib.ecoulement_ajustement.argtypes = [solveur]
+    bib.ecoulement_ajustement.restype = ctc_t
+    bib.ecoulement_detruire.argtypes = [solveur]
+    bib.ecoulement_detruire.restype = None
+
+    return bib
+
+
+_bib = _charger_bibliotheque()
+
+
+class Solveur:
+    """
+    Solveur d'écoulement de chaleur sur trois plans de largeur x hauteur
+    valeurs float32, rangée par rangée
+    """
+
+    def __init__(self, chaleur, temperature, conduction, largeur, hauteur):
+        n = largeur * hauteur
+
+        # Vues ctypes sur les tampons, gardées tant que vit le solveur
+        self._plans = [(ctc_t * n).from_buffer(plan)
+                       for plan in (chaleur, temperature, conduction)]
+        self._solveur = _bib.ecoulement_creer(
+            *[ctypes.cast(p, ctypes.POINTER(ctc_t)) for p in self._plans],
+            largeur, hauteur)
+
+        if not self._solveur:
+            raise ValueError("grille de moins de 3x3 points")
+
+    def __del__(self):
+        if getattr(self, "_solveur", None):
+            _bib.ecoulement_detruire(self._solveur)
+            self._solveur = None
+
+    def configurer(self, bruit=BRUIT, seuil_convergence=SEUIL_CONVERGENCE,
+                   nb_max_iter=NB_MAX_ITER, bloc=1):
+        """
+        Changer les paramètres d'exécution, en degrés
+        """
+
+        _bib.ecoulement_configurer(self._solveur, bruit, seuil_convergence,
+                                   nb_max_iter, bloc)
+
+    def avancer(self, nb_pas=1):
+        """
+        Effectuer nb_pas itérations, sans test de convergence
+
+        Retourne: L'ajustement moyen de la dernière itération
+        """
+
+        return _bib.ecoulement_avancer(self._solveur, nb_pas)
+
+    def converger(self, rappel=None):
+        """
+        Itérer jusqu'à la convergence ou la limite d'itérations
+
+        rappel - Fonction (nb_iter, delta_temp) appelée toutes les « bloc »
+                 itérations ; retourner False interrompt la convergence
+
+        Retourne: Le nombre total d'itérations effectuées
+        """
+
+        erreurs = []
+
+        def relayer(nb_iter, delta_temp, donnee):
+            try:
+                return 0 if rappel(nb_iter, delta_temp) is False else 1
+            except Exception as erreur:
+                erreurs.append(erreur)
+                return 0
+
+        relais = _PROGRESSION(relayer) if rappel else _PROGRESSION()
+        nb_iter = _bib.ecoulement_converger(self._solveur, relais, None)
+
+        if erreurs:
+            raise erreurs[0]
+
+        return nb_iter
+
+    @property
+    def iterations(self):
+        return _bib.ecoulement_iterations(self._solveur)
+
+    @property
+    def ajustement(self):
+        return _bib.ecoulement_ajustement(self._solveur)
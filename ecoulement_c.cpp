@@ -0,0 +1,92 @@
+#include <new>
+
+#include "ecoulement.h"
+#include "ecoulement_c.h"
+
+
+static_assert(sizeof(ecoulement_reel) == sizeof(ctc_t),
+              "ecoulement_reel doit être ctc_t");
+
+/**
+ * Solveur de l'interface C, avec le rappel C à relayer
+ */
+struct ecoulement_solveur {
+    ecoulement_solveur(ctc_t * chaleur, ctc_t * temperature,
+                       ctc_t * conduction, std::size_t largeur,
+                       std::size_t hauteur):
+        solveur(chaleur, temperature, conduction, largeur, hauteur),
+        rappel(NULL), donnee(NULL) {}
+
+    /**
+     * Relais du rappel de SolveurCTC vers le rappel C
+     */
+    static bool relayer(unsigned int nb_iter, ctc_t delta_temp, void * s) {
+        const ecoulement_solveur * e = static_cast<ecoulement_solveur *>(s);
+
+        return e->rappel(nb_iter, delta_temp, e->donnee) != 0;
+    }
+
+    SolveurCTC solveur;
+    ecoulement_progression rappel;
+    void * donnee;
+};
+
+
+ecoulement_solveur * ecoulement_creer(ecoulement_reel * chaleur,
+                                      ecoulement_reel * temperature,
+                                      ecoulement_reel * conduction,
+                                      size_t largeur, size_t hauteur)
+{
+    if (chaleur == NULL || temperature == NULL || conduction == NULL ||
+        largeur < 3 || hauteur < 3)
+        return NULL;
+
+    return new (std::nothrow) ecoulement_solveur(
+        chaleur, temperature, conduction, largeur, hauteur);
+}
+
+void ecoulement_configurer(ecoulement_solveur * solveur, double bruit,
+                           double seuil_convergence, unsigned int nb_max_iter,
+                           unsigned int bloc)
+{
+    Configuration config;
+
+    config.bruit = bruit;
+    config.seuil_convergence = seuil_convergence;
+    config.nb_max_iter = nb_max_iter;
+    config.bloc = std::max(1u, bloc);
+    solveur->solveur.configurer(config);
+}
+
+ecoulement_reel ecoulement_avancer(ecoulement_solveur * solveur,
+                                   unsigned int nb_pas)
+{
+    return solveur->solveur.avancer(nb_pas);
+}
+
+unsigned int ecoulement_converger(ecoulement_solveur * solveur,
+                                  ecoulement_progression rappel,
+                                  void * donnee)
+{
+    if (rappel == NULL)
+        return solveur->solveur.converger();
+
+    solveur->rappel = rappel;
+    solveur->donnee = donnee;
+    return solveur->solveur.converger(&ecoulement_solveur::relayer, solveur);
+}
+
+unsigned int ecoulement_iterations(const ecoulement_solveur * solveur)
+{
+    return solveur->solveur.nb_iterations();
+}
+
+ecoulement_reel ecoulement_ajustement(const ecoulement_solveur * solveur)
+{
+    return solveur->solveur.ajustement();
+}
+
+void ecoulement_detruire(ecoulement_solveur * solveur)
+{
+    delete solveur;
+}
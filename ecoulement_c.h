@@ -0,0 +1,80 @@
+/**
+ * Interface C de libecoulement (make bibliotheque) : un solveur fait
+ * évoluer une grille dont l'appelant fournit les trois plans de chaleur,
+ * de température et de conduction, sans copie. Les températures sont
+ * mises à jour sur place. Les paramètres sont en degrés, comme
+ * ceux de la structure Configuration (6.4 / 256 pour le bruit par défaut).
+ */
+#ifndef ECOULEMENT_C_H
+#define ECOULEMENT_C_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Type des valeurs des plans, celui de ctc_t à la compilation */
+#ifdef CTC_DOUBLE
+typedef double ecoulement_reel;
+#else
+typedef float ecoulement_reel;
+#endif
+
+typedef struct ecoulement_solveur ecoulement_solveur;
+
+/**
+ * Rappel de progression, appelé toutes les « bloc » itérations
+ * @return 0 pour interrompre la convergence
+ */
+typedef int (*ecoulement_progression)(unsigned int nb_iter,
+                                      ecoulement_reel delta_temp,
+                                      void * donnee);
+
+/**
+ * Créer un solveur sur des plans de largeur x hauteur valeurs, rangée par
+ * rangée, qui doivent vivre plus longtemps que le solveur
+ * @return NULL si un plan manque ou si la grille a moins de 3x3 points
+ */
+ecoulement_solveur * ecoulement_creer(ecoulement_reel * chaleur,
+                                      ecoulement_reel * temperature,
+                                      ecoulement_reel * conduction,
+                                      size_t largeur, size_t hauteur);
+
+/**
+ * Changer les paramètres d'exécution
+ * @param bruit Bruit ajouté à la moyenne des voisins
+ * @param seuil_convergence Ajustement moyen d'une grille stabilisée
+ * @param nb_max_iter Limite du nombre total d'itérations
+ * @param bloc Itérations entre deux tests de convergence et rappels
+ */
+void ecoulement_configurer(ecoulement_solveur * solveur, double bruit,
+                           double seuil_convergence, unsigned int nb_max_iter,
+                           unsigned int bloc);
+
+/**
+ * Effectuer nb_pas itérations, sans test de convergence
+ * @return L'ajustement moyen de la dernière itération
+ */
+ecoulement_reel ecoulement_avancer(ecoulement_solveur * solveur,
+                                   unsigned int nb_pas);
+
+/**
+ * Itérer jusqu'à la convergence, la limite d'itérations ou l'interruption
+ * par le rappel (qui peut être NULL)
+ * @return Le nombre total d'itérations effectuées
+ */
+unsigned int ecoulement_converger(ecoulement_solveur * solveur,
+                                  ecoulement_progression rappel,
+                                  void * donnee);
+
+unsigned int ecoulement_iterations(const ecoulement_solveur * solveur);
+ecoulement_reel ecoulement_ajustement(const ecoulement_solveur * solveur);
+
+void ecoulement_detruire(ecoulement_solveur * solveur);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* ECOULEMENT_C_H */
@@ -1,274 +1,611 @@
-#include <algorithm>
-#include <array>
-#include <cmath>
-#include <cstring>
-#include <iostream>
-#include <numeric>
-#include <png.h>
-#include <string>
-#include <vector>
+#include <fstream>
+#include <getopt.h>
+#include <sstream>
 
+#include "ecoulement.h"
 
-typedef float ctc_t;
-const ctc_t BRUIT = 6.4 / 256;  // 6.4 unités de la résolution de 8 bits
-const ctc_t SEUIL_CONVERGENCE = 0.5 / 256;  // 0.5 unité par pixel
-const unsigned int NB_MAX_ITER = 5000; // Limiter le temps de calcul
 
+/**
+ * Plateau d'un lot : image des conditions initiales et image résultante
+ */
+struct Plateau {
+    std::string entree;
+    std::string sortie;
+    std::size_t nb_points;  // Pour répartir les plus grands en premier
+};
 
 /**
- * Classe facilitant la lecture-écriture (Le) de fichiers PNG en RGB
+ * Nom de l'image résultante d'un plateau de lot : carte.png donne
+ * carte-resultat.png, dans le même dossier
  */
-class LePNG: public std::vector<png_color>
+std::string nom_resultat(const std::string & entree)
 {
-public:
-    LePNG() {
-        memset(&entete, 0, sizeof entete);
+    const std::size_t point = entree.rfind('.');
+    const std::size_t dossier = entree.rfind('/');
+    const bool extension = point != std::string::npos &&
+        (dossier == std::string::npos || point > dossier);
 
-        entete.format = PNG_FORMAT_RGB;
-        entete.version = PNG_IMAGE_VERSION;
-    }
+    return (extension ? entree.substr(0, point) : entree) + "-resultat.png";
+}
 
-    virtual ~LePNG() {
-        png_image_free(&entete);
-    }
+/**
+ * Lire le manifeste d'un lot : un plateau par ligne, l'image d'entrée
+ * suivie facultativement de l'image résultante. Les lignes vides et
+ * celles commençant par # sont ignorées.
+ * @param nom_fichier Fichier manifeste
+ * @param plateaux Liste à compléter
+ */
+void lire_manifeste(const std::string & nom_fichier,
+                    std::vector<Plateau> & plateaux)
+{
+    std::ifstream manifeste(nom_fichier);
+    std::string ligne;
 
-    /**
-     * Charger une image d'un fichier PNG - Triple canal (Red, Green, Blue)
-     */
-    void charger(const std::string & nom_fichier) {
-        if (!png_image_begin_read_from_file(&entete, nom_fichier.c_str()))
-            throw nom_fichier + " - " + entete.message;
+    if (!manifeste)
+        throw nom_fichier + " - " + std::strerror(errno);
 
-        resize(entete.width * entete.height);
+    while (std::getline(manifeste, ligne)) {
+        std::istringstream champs(ligne);
+        Plateau plateau;
 
-        if (!png_image_finish_read(&entete, NULL, data(), 0, NULL))
-            throw nom_fichier + " - " + entete.message;
+        if (!(champs >> plateau.entree) || plateau.entree[0] == '#')
+            continue;
+        if (!(champs >> plateau.sortie))
+            plateau.sortie = nom_resultat(plateau.entree);
+        plateaux.push_back(plateau);
     }
+}
 
-    /**
-     * Enregistrer le résultat dans un fichier PNG
-     */
-    void enregistrer(const std::string & nom_fichier) {
-        if (!png_image_write_to_file(
-                &entete, nom_fichier.c_str(), 0, data(), 0, NULL)) {
-            throw nom_fichier + " - " + entete.message;
+/**
+ * Résoudre un lot de plateaux indépendants, répartis entre des fils
+ * OpenMP. Chaque fil copie le modèle prototype une seule fois et le
+ * réutilise d'un plateau à l'autre : ses plans gardent leur allocation, et
+ * les plus grands plateaux passent en premier pour que les suivants
+ * tiennent dans la mémoire déjà réservée et que les fils finissent
+ * ensemble. Les statistiques de chaque plateau sont préfixées de son nom.
+ * @param plateaux Plateaux à résoudre
+ * @param prototype Modèle configuré (noyaux, fils, etc.), encore vide
+ * @param config Paramètres d'exécution du solveur
+ * @param nb_travaux Nombre de plateaux traités à la fois, 0 pour un par
+ *                   cœur
+ * @param rapport Flux recevant le rapport JSON de chaque plateau, ou NULL
+ * @param modele Nom du modèle, pour les rapports
+ * @return Le code de sortie le plus grave parmi les plateaux
+ */
+template <class Modele>
+int simuler_lot(std::vector<Plateau> plateaux, const Modele & prototype,
+                const Configuration & config, int nb_travaux,
+                std::ostream * rapport, const std::string & modele)
+{
+    for (Plateau & plateau : plateaux) {
+        // Taille lue dans l'en-tête ; l'erreur éventuelle sera affichée
+        // par simuler()
+        try {
+            LecteurPNG lecteur;
+
+            lecteur.ouvrir(plateau.entree);
+            plateau.nb_points =
+                (std::size_t)lecteur.largeur() * lecteur.hauteur();
+        }
+        catch (const std::string message) {
+            plateau.nb_points = 0;
         }
     }
 
-    inline png_uint_32 largeur() const { return entete.width; }
-    inline png_uint_32 hauteur() const { return entete.height; }
+    std::stable_sort(plateaux.begin(), plateaux.end(),
+        [](const Plateau & a, const Plateau & b) {
+            return a.nb_points > b.nb_points;
+        });
 
-private:
-    png_image entete;
-};
+    int code = 0;
+
+    if (nb_travaux <= 0)
+        nb_travaux = std::max(1u, std::thread::hardware_concurrency());
+
+    #pragma omp parallel num_threads(nb_travaux) if(nb_travaux > 1)
+    {
+        Modele carte(prototype);
+
+        #pragma omp for schedule(dynamic, 1)
+        for (long p = 0; p < (long)plateaux.size(); ++p) {
+            std::ostringstream journal;
+            RapportCalcul mesures;
+            const int resultat = simuler(plateaux[p].entree,
+                plateaux[p].sortie, carte, config, journal, &mesures);
+
+            #pragma omp critical(journal_lot)
+            {
+                std::istringstream lignes(journal.str());
+                std::string ligne;
+
+                while (std::getline(lignes, ligne))
+                    std::cout << plateaux[p].entree << " : " << ligne << "\n";
+                std::cout.flush();
+                if (rapport != NULL && resultat != 2)
+                    mesures.ecrire_json(*rapport, plateaux[p].entree, modele);
+                code = std::max(code, resultat);
+            }
+        }
+    }
 
+    return code;
+}
 
 /**
- * Triplet (Chaleur, Température, Conduction)
+ * Résoudre un plateau seul ou un lot de plateaux avec un modèle configuré,
+ * et écrire le rapport JSON de chaque plateau dans le flux rapport s'il
+ * n'est pas NULL
  */
-typedef struct {
-    ctc_t chaleur;      // Intensité de la source de chaleur
-    ctc_t temperature;  // Température en degrés Celsius
-    ctc_t conduction;   // Facteur de conduction de chaleur
-} CTC;
+template <class Modele>
+int executer(const std::vector<Plateau> & plateaux, Modele & carte,
+             const Configuration & config, bool lot, int nb_travaux,
+             std::ostream * rapport, const std::string & modele)
+{
+    if (lot) {
+        return simuler_lot(plateaux, carte, config, nb_travaux, rapport,
+                           modele);
+    }
+
+    RapportCalcul mesures;
+    const std::string & entree = config.reprise.empty() ?
+        plateaux[0].entree : config.reprise;
+    const int code = simuler(plateaux[0].entree, plateaux[0].sortie, carte,
+                             config, std::cout, &mesures);
+
+    // Sans modèle chargé, il n'y a rien à rapporter
+    if (rapport != NULL && code != 2)
+        mesures.ecrire_json(*rapport, entree, modele);
+
+    return code;
+}
 
 
 /**
- * Modèle de grille 2D de valeurs de chaleur, température et conduction
+ * Afficher la syntaxe d'appel du programme
  */
-class ModeleCTC: public std::vector<CTC>
+void usage(const char * programme)
 {
-public:
-    ModeleCTC(): larg(0), haut(0) {}
+    std::cerr << "Usage: " << programme << " [options] fichier.png...\n"
+        << "       " << programme << " [options] -l manifeste\n"
+        << "       " << programme << " [options] -r sauvegarde.ctc\n"
+        << "Options:\n"
+        << "  -m, --modele NOM  Disposition mémoire du modèle :\n"
+        << "                    triplets (défaut), plans, damier, simd\n"
+        << "                    compact ou gpu (make gpu)\n"
+        << "  -p, --precision P Stockage des températures du modèle compact :\n"
+        << "                    f32 (défaut), f16 ou bf16\n"
+        << "  -t, --fils N      Nombre de fils OpenMP (damier et simd)\n"
+        << "  -B, --epingler MODE  Épingler les fils (ou ceux d'un lot)\n"
+        << "                    sur des processeurs : proche (consécutifs)\n"
+        << "                    ou reparti (espacés sur les sockets)\n"
+        << "  -k, --bloc K      Tester la convergence aux K itérations ;\n"
+        << "                    tuilage temporel avec damier et simd\n"
+        << "  -a, --actives     Ne calculer que les tuiles actives\n"
+        << "                    (damier et simd)\n"
+        << "  -w, --omega W     Sur-relaxation (SOR) de facteur W avec\n"
+        << "                    damier ; 0 pour l'estimer selon la grille\n"
+        << "  -n, --multigrille N  Résoudre d'abord N grilles grossières\n"
+        << "                    pour initialiser les températures\n"
+        << "  -b, --bruit B     Bruit ajouté à la moyenne des voisins,\n"
+        << "                    en unités de 1/256 (défaut 6.4)\n"
+        << "  -s, --seuil S     Ajustement moyen de convergence,\n"
+        << "                    en unités de 1/256 (défaut 0.5)\n"
+        << "  -C, --critere NOM Variation comparée au seuil : moyenne\n"
+        << "                    (défaut) ou max, celle du point qui varie\n"
+        << "                    le plus\n"
+        << "  -i, --iterations N  Nombre maximal d'itérations (défaut 5000)\n"
+        << "  -A, --anticiper T Arrêter dès que la variation restante\n"
+        << "                    prévue passe sous T, en unités de 1/256\n"
+        << "  -F, --fenetre N   Lots mesurés pour estimer le taux de\n"
+        << "                    convergence (défaut 16)\n"
+        << "  -x, --extrapoler  Extrapoler les températures vers le point\n"
+        << "                    fixe (Aitken) selon le taux estimé\n"
+        << "  -e, --instantanes N  Enregistrer une image toutes les N\n"
+        << "                    itérations, écrite en arrière-plan\n"
+        << "  -o, --motif M     Nom des instantanés, le %u étant remplacé\n"
+        << "                    par l'itération (instantane-%05u.png)\n"
+        << "  -S, --sauvegarde F  Sauvegarder l'état du calcul dans F\n"
+        << "                    à la fin\n"
+        << "  -P, --periode N   Sauvegarder aussi toutes les N itérations\n"
+        << "  -r, --reprise F   Reprendre le calcul d'une sauvegarde\n"
+        << "  -l, --lot F       Résoudre les plateaux listés dans F, une\n"
+        << "                    image par ligne et sa sortie facultative ;\n"
+        << "                    de même avec plusieurs fichier.png\n"
+        << "  -j, --travaux N   Plateaux d'un lot résolus à la fois\n"
+        << "                    (make openmp ; défaut : un par cœur)\n"
+        << "  -R, --rapport F   Ajouter à F (- pour la sortie standard)\n"
+        << "                    la durée des phases et le débit de chaque\n"
+        << "                    plateau, en JSON, un objet par ligne\n"
+        << "  -c, --compteurs   Ajouter au rapport les cycles, instructions\n"
+        << "                    et défauts de cache de la convergence"
+        << std::endl;
+}
 
-    /**
-     * Redimensionner la grille
-     */
-    void redimensionner(std::size_t largeur, std::size_t hauteur) {
-        larg = largeur;
-        haut = hauteur;
 
-        resize(larg * haut);
+/**
+ * Programme principal
+ */
+int main(int argc, char** argv)
+{
+    std::string modele("triplets");
+    Configuration config;
+    int nb_fils = 0;
+    Epinglage epinglage = EPINGLAGE_AUCUN;
+    int bloc = 1;
+    int nb_niveaux = 0;
+    int nb_max_iter;
+    int instantanes;
+    int periode;
+    double omega = -1.;  // Négatif sans SOR
+    bool actives = false;
+    std::string precision;
+    std::string manifeste;
+    int nb_travaux = 0;
+    std::string nom_rapport;
+
+    const struct option options[] = {
+        {"modele", required_argument, NULL, 'm'},
+        {"fils", required_argument, NULL, 't'},
+        {"epingler", required_argument, NULL, 'B'},
+        {"bloc", required_argument, NULL, 'k'},
+        {"actives", no_argument, NULL, 'a'},
+        {"precision", required_argument, NULL, 'p'},
+        {"omega", required_argument, NULL, 'w'},
+        {"multigrille", required_argument, NULL, 'n'},
+        {"bruit", required_argument, NULL, 'b'},
+        {"seuil", required_argument, NULL, 's'},
+        {"critere", required_argument, NULL, 'C'},
+        {"iterations", required_argument, NULL, 'i'},
+        {"anticiper", required_argument, NULL, 'A'},
+        {"fenetre", required_argument, NULL, 'F'},
+        {"extrapoler", no_argument, NULL, 'x'},
+        {"instantanes", required_argument, NULL, 'e'},
+        {"motif", required_argument, NULL, 'o'},
+        {"sauvegarde", required_argument, NULL, 'S'},
+        {"periode", required_argument, NULL, 'P'},
+        {"reprise", required_argument, NULL, 'r'},
+        {"lot", required_argument, NULL, 'l'},
+        {"travaux", required_argument, NULL, 'j'},
+        {"rapport", required_argument, NULL, 'R'},
+        {"compteurs", no_argument, NULL, 'c'},
+        {NULL, 0, NULL, 0}
+    };
+    const char * options_courtes = "m:t:B:k:ap:w:n:b:s:C:i:A:F:xe:o:S:P:r:l:j:R:c";
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, options_courtes, options, NULL))
+           != -1) {
+        switch (opt) {
+        case 'm':
+            modele = optarg;
+            break;
+        case 't':
+            nb_fils = std::atoi(optarg);
+            if (nb_fils < 1) {
+                std::cerr << "Erreur: nombre de fils invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            break;
+        case 'B':
+            if (std::string(optarg) == "proche")
+                epinglage = EPINGLAGE_PROCHE;
+            else if (std::string(optarg) == "reparti")
+                epinglage = EPINGLAGE_REPARTI;
+            else {
+                std::cerr << "Erreur: épinglage inconnu - " << optarg
+                    << std::endl;
+                return 1;
+            }
+            break;
+        case 'k':
+            bloc = std::atoi(optarg);
+            if (bloc < 1) {
+                std::cerr << "Erreur: taille de bloc invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            config.bloc = bloc;
+            break;
+        case 'a':
+            actives = true;
+            break;
+        case 'p':
+            precision = optarg;
+            break;
+        case 'w':
+            omega = std::atof(optarg);
+            if (omega != 0 && (omega < 1 || omega >= 2)) {
+                std::cerr << "Erreur: facteur de sur-relaxation invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            break;
+        case 'n':
+            nb_niveaux = std::atoi(optarg);
+            if (nb_niveaux < 0) {
+                std::cerr << "Erreur: nombre de niveaux invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            config.nb_niveaux = nb_niveaux;
+            break;
+        case 'b':
+            config.bruit = std::atof(optarg) / 256;
+            break;
+        case 's':
+            config.seuil_convergence = std::atof(optarg) / 256;
+            if (config.seuil_convergence <= 0) {
+                std::cerr << "Erreur: seuil de convergence invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            break;
+        case 'C':
+            if (std::string(optarg) == "moyenne")
+                config.critere = CRITERE_MOYENNE;
+            else if (std::string(optarg) == "max")
+                config.critere = CRITERE_MAX;
+            else {
+                std::cerr << "Erreur: critère de convergence inconnu - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            break;
+        case 'i':
+            nb_max_iter = std::atoi(optarg);
+            if (nb_max_iter < 1) {
+                std::cerr << "Erreur: nombre d'itérations invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            config.nb_max_iter = nb_max_iter;
+            break;
+        case 'A':
+            config.tolerance_restante = std::atof(optarg) / 256;
+            if (config.tolerance_restante <= 0) {
+                std::cerr << "Erreur: tolérance restante invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            break;
+        case 'F':
+            if (std::atoi(optarg) < 3) {
+                std::cerr << "Erreur: fenêtre de convergence invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            config.fenetre = std::atoi(optarg);
+            break;
+        case 'x':
+            config.extrapolation = true;
+            break;
+        case 'e':
+            instantanes = std::atoi(optarg);
+            if (instantanes < 1) {
+                std::cerr << "Erreur: intervalle d'instantanés invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            config.instantanes = instantanes;
+            break;
+        case 'o':
+            if (!motif_valide(optarg)) {
+                std::cerr << "Erreur: le motif doit contenir un seul %u - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            config.motif_instantanes = optarg;
+            break;
+        case 'S':
+            config.sauvegarde = optarg;
+            break;
+        case 'P':
+            periode = std::atoi(optarg);
+            if (periode < 1) {
+                std::cerr << "Erreur: période de sauvegarde invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            config.periode_sauvegarde = periode;
+            break;
+        case 'r':
+            config.reprise = optarg;
+            break;
+        case 'l':
+            manifeste = optarg;
+            break;
+        case 'j':
+            nb_travaux = std::atoi(optarg);
+            if (nb_travaux < 1) {
+                std::cerr << "Erreur: nombre de travaux invalide - "
+                    << optarg << std::endl;
+                return 1;
+            }
+            break;
+        case 'R':
+            nom_rapport = optarg;
+            break;
+        case 'c':
+            config.compteurs = true;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
     }
 
-    /**
-     * Accès à un triplet (Chaleur, Température, Conduction)
-     */
-    inline CTC& ctc(std::size_t rangee, std::size_t colonne) {
-        return at(rangee * larg + colonne);
-    }
-    inline const CTC& ctc(std::size_t rangee, std::size_t colonne) const {
-        return at(rangee * larg + colonne);
-    }
+    // Des images ou une sauvegarde, mais pas les deux
+    const bool lot = !manifeste.empty() || argc - optind > 1;
 
-    /**
-     * Accès à une composante
-     */
-    inline ctc_t chaleur(std::size_t rangee, std::size_t colonne) const {
-        return at(rangee * larg + colonne).chaleur;
+    if ((optind >= argc && manifeste.empty()) == config.reprise.empty()) {
+        usage(argv[0]);
+        return 1;
     }
-    inline ctc_t temperature(std::size_t rangee, std::size_t colonne) const {
-        return at(rangee * larg + colonne).temperature;
+
+    if (lot && (!config.reprise.empty() || !config.sauvegarde.empty() ||
+                config.instantanes > 0)) {
+        std::cerr << "Erreur: les options --sauvegarde, --reprise et "
+            << "--instantanes ne s'appliquent pas à un lot" << std::endl;
+        return 1;
     }
-    inline ctc_t conduction(std::size_t rangee, std::size_t colonne) const {
-        return at(rangee * larg + colonne).conduction;
+
+    if (nb_travaux > 0 && !lot) {
+        std::cerr << "Erreur: l'option --travaux requiert un lot"
+            << std::endl;
+        return 1;
     }
 
-    inline std::size_t largeur() const { return larg; }
-    inline std::size_t hauteur() const { return haut; }
-
-    /**
-     * Effectuer une itération d'écoulement de chaleur sur toute la grille
-     * @return La différence de température moyenne
-     */
-    ctc_t un_pas_de_temps() {
-        ctc_t somme_delta = 0.;
-
-        // Converge plus vite si on traite en damier (une couleur à la fois)
-        for (auto impair = 0; impair < 2; ++impair) {
-            // Laisser faire la marge de 1 pixel
-            for (auto i = 1; i < haut - 1; ++i) {
-                auto depart = (((i + 1) ^ impair) & 1);  // Damier
-
-                for (auto j = 1 + depart; j < larg - 1; j += 2) {
-                    ctc_t conduct = conduction(i, j);
-                    ctc_t ancienne_temp = temperature(i, j);
-                    ctc_t nouvelle_temp = std::max(chaleur(i, j), (
-                        temperature(i - 1, j) +
-                        temperature(i, j - 1) +
-                        temperature(i, j + 1) +
-                        temperature(i + 1, j) ) / 4 + BRUIT);
-                    ctc_t delta_temp = conduct *
-                        (nouvelle_temp - ancienne_temp);
-
-                    ctc(i, j).temperature += delta_temp;
-                    somme_delta += std::abs(delta_temp);
-                }
-            }
-        }
+    // Un seul plateau écrit resultat.png ; ceux d'un lot, chacun le sien
+    std::vector<Plateau> plateaux;
 
-        return somme_delta / (larg * haut);
-    }
+    if (!config.reprise.empty())
+        plateaux.push_back(Plateau {"", "resultat.png", 0});
 
-private:
-    std::size_t larg;
-    std::size_t haut;
-};
+    for (int a = optind; a < argc; ++a) {
+        plateaux.push_back(Plateau {
+            argv[a], lot ? nom_resultat(argv[a]) : "resultat.png", 0
+        });
+    }
 
+    if (!manifeste.empty()) {
+        try {
+            lire_manifeste(manifeste, plateaux);
+        }
+        catch (const std::string message) {
+            std::cerr << "Erreur: " << message << std::endl;
+            return 2;
+        }
 
-/**
- * Normaliser la température selon les températures minimale et maximale.
- * Convertir cette valeur de 0..1 en couleur sur un dégradé de noir, à bleu,
- * à magenta, à rouge, à jaune et à blanc, selon une courbe de Bézier.
- *
- * @param temp Température à normaliser
- * @param t_min Température minimale mesurée
- * @param t_max Température maximale mesurée
- * @return Pixel RGB de type png_color selon la valeur de temp.
- */
-png_color normaliser_couleur(ctc_t temp, ctc_t t_min, ctc_t t_max)
-{
-    const ctc_t t = (temp - t_min) / (t_max - t_min);
-    std::vector<std::array<double, 3>> couleurs {{
-       {  0,   0,   0},  // Noir
-       {  0,   0, 255},  // Bleu
-       {255,   0, 255},  // Magenta
-       {255,   0,   0},  // Rouge
-       {255, 255,   0},  // Jaune
-       {255, 255, 255}   // Blanc
-    }};
-
-    // Calcul itératif de la courbe de Bézier dans l'espace des couleurs
-    for (auto iter = 1; iter < couleurs.size(); ++iter) {
-        for (auto i = 0; i < couleurs.size() - iter; ++i) {
-            couleurs[i][0] += t * (couleurs[i + 1][0] - couleurs[i][0]);
-            couleurs[i][1] += t * (couleurs[i + 1][1] - couleurs[i][1]);
-            couleurs[i][2] += t * (couleurs[i + 1][2] - couleurs[i][2]);
+        if (plateaux.empty()) {
+            std::cerr << "Erreur: " << manifeste << " - lot vide"
+                << std::endl;
+            return 2;
         }
     }
 
-    return png_color {
-        (png_byte)couleurs[0][0],
-        (png_byte)couleurs[0][1],
-        (png_byte)couleurs[0][2]
-    };
-}
+    if (config.periode_sauvegarde > 0 && config.sauvegarde.empty()) {
+        std::cerr << "Erreur: l'option --periode requiert --sauvegarde"
+            << std::endl;
+        return 1;
+    }
 
+    if (config.compteurs && nom_rapport.empty()) {
+        std::cerr << "Erreur: l'option --compteurs requiert --rapport"
+            << std::endl;
+        return 1;
+    }
 
-/**
- * Programme principal
- */
-int main(int argc, char** argv)
-{
-    LePNG png;
-    ModeleCTC carte_gpu;
+#ifndef _OPENMP
+    if (nb_fils > 0 || nb_travaux > 1) {
+        std::cerr << "Avertissement: programme compilé sans OpenMP "
+            << "(make openmp), calcul séquentiel" << std::endl;
+    }
+#endif
+
+    if (nb_fils > 0 && modele != "damier" && modele != "simd") {
+        std::cerr << "Erreur: l'option --fils requiert le modèle "
+            << "damier ou simd" << std::endl;
+        return 1;
+    }
 
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " fichier.png" << std::endl;
+    if (actives && modele != "damier" && modele != "simd") {
+        std::cerr << "Erreur: l'option --actives requiert le modèle "
+            << "damier ou simd" << std::endl;
         return 1;
     }
 
-    try {
-        // Charger l'image
-        std::string nom_fichier(argv[1]);
-        png.charger(nom_fichier);
-
-        // Tranformer les pixels RGB en triplets CTC
-        carte_gpu.redimensionner(png.largeur(), png.hauteur());
-        std::transform(png.cbegin(), png.cend(), carte_gpu.begin(),
-            [](const png_color & pixel) {
-                return CTC {
-                    (ctc_t)pixel.red,
-                    (ctc_t)pixel.green,
-                    (ctc_t)pixel.blue / 256
-                };
-            });
+    if (!precision.empty() && modele != "compact") {
+        std::cerr << "Erreur: l'option --precision requiert le modèle "
+            << "compact" << std::endl;
+        return 1;
     }
-    catch (const std::string message) {
-        std::cerr << "Erreur: " << message << std::endl;
-        return 2;
+
+    if (omega >= 0 && modele != "damier") {
+        std::cerr << "Erreur: l'option --omega requiert le modèle damier"
+            << std::endl;
+        return 1;
     }
 
-    // Boucle principale
-    ctc_t delta_temp = SEUIL_CONVERGENCE + 1.;
-    unsigned int nb_iter = 0;
+    // Avant toute allocation de grille, pour le placement des pages
+    const int nb_epingles = !lot ? std::max(nb_fils, 1) : nb_travaux > 0 ?
+        nb_travaux : std::max(1u, std::thread::hardware_concurrency());
 
-    while (delta_temp > SEUIL_CONVERGENCE && nb_iter < NB_MAX_ITER) {
-        delta_temp = carte_gpu.un_pas_de_temps();
-        nb_iter++;
+    if (!epingler_fils(nb_epingles, epinglage)) {
+        std::cerr << "Avertissement: épinglage des fils impossible"
+            << std::endl;
     }
 
-    // Calcul et affichage de statistiques
-    const auto minmax = std::minmax_element(
-        carte_gpu.cbegin(), carte_gpu.cend(),
-        [](const CTC & a, const CTC & b) {
-            return a.temperature < b.temperature;
-        });
-    std::cout << "Itération #" << nb_iter
-        << ", ajustement moyen = " << delta_temp * 256 << " / 256"
-        << ", t_min = " << minmax.first->temperature
-        << ", t_max = " << minmax.second->temperature
-        << std::endl;
+    // Les rapports s'accumulent d'une exécution à l'autre
+    std::ofstream fichier_rapport;
+    std::ostream * rapport = NULL;
+    const std::string nom_modele = precision.empty() ? modele :
+        modele + "-" + precision;
+
+    if (nom_rapport == "-")
+        rapport = &std::cout;
+    else if (!nom_rapport.empty()) {
+        fichier_rapport.open(nom_rapport, std::ios::app);
+        if (!fichier_rapport) {
+            std::cerr << "Erreur: " << nom_rapport << " - "
+                << std::strerror(errno) << std::endl;
+            return 2;
+        }
+        rapport = &fichier_rapport;
+    }
+
+    if (modele == "triplets") {
+        ModeleCTC carte_gpu;
+        return executer(plateaux, carte_gpu, config, lot, nb_travaux,
+                        rapport, nom_modele);
+    }
+    else if (modele == "plans") {
+        ModeleCTCPlans carte_gpu;
+        return executer(plateaux, carte_gpu, config, lot, nb_travaux,
+                        rapport, nom_modele);
+    }
+    else if (modele == "compact") {
+        if (precision.empty() || precision == "f32") {
+            ModeleCTCCompact<float> carte_gpu;
+            return executer(plateaux, carte_gpu, config, lot, nb_travaux,
+                            rapport, nom_modele);
+        }
+        else if (precision == "f16") {
+            ModeleCTCCompact<Demi> carte_gpu;
+            return executer(plateaux, carte_gpu, config, lot, nb_travaux,
+                            rapport, nom_modele);
+        }
+        else if (precision == "bf16") {
+            ModeleCTCCompact<BFloat16> carte_gpu;
+            return executer(plateaux, carte_gpu, config, lot, nb_travaux,
+                            rapport, nom_modele);
+        }
 
-    try {
-        // Tranformer les températures en pixels RGB
-        std::transform(carte_gpu.cbegin(), carte_gpu.cend(), png.begin(),
-            [minmax](const CTC & ctc) {
-                return normaliser_couleur(
-                    ctc.temperature,
-                    minmax.first->temperature,
-                    minmax.second->temperature
-                );
-            });
-
-        // Enregistrer l'image résultante
-        png.enregistrer("resultat.png");
+        std::cerr << "Erreur: précision inconnue - " << precision
+            << std::endl;
+        return 1;
+    }
+    else if (modele == "gpu") {
+        ModeleCTCGPU carte_gpu;
+        return executer(plateaux, carte_gpu, config, lot, nb_travaux,
+                        rapport, nom_modele);
     }
-    catch (const std::string message) {
-        std::cerr << "Erreur: " << message << std::endl;
-        return 3;
+    else if (modele == "damier" || modele == "simd") {
+        ModeleCTCDamier carte_gpu;
+
+        if (modele == "simd")
+            carte_gpu.activer_simd();
+        if (omega >= 0)
+            carte_gpu.activer_sor(omega);
+        if (actives)
+            carte_gpu.activer_tuiles();
+        carte_gpu.activer_fils(nb_fils);
+
+        return executer(plateaux, carte_gpu, config, lot, nb_travaux,
+                        rapport, nom_modele);
     }
 
-    return 0;
+    std::cerr << "Erreur: modèle inconnu - " << modele << std::endl;
+    usage(argv[0]);
+    return 1;
 }
-
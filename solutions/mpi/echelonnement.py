@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""
+Mesure de l'extensibilité de la solution MPI sur des grilles synthétiques
+(option --generer), en échelle forte (grille fixe) et faible (grille
+proportionnelle au nombre de processus)
+
+    python3 echelonnement.py --processus 1,2,4,8 --cote-fort 4096 \\
+        --cote-faible 1024 --iterations 200 --csv rangs.csv
+
+Chaque exécution ajoute son rapport JSON (--rapport) au fichier --brut ;
+le tableau d'efficacité parallèle est affiché à la fin, et le temps de
+chaque processus est enregistré dans le fichier --csv. Le nombre
+d'itérations et les températures extrêmes de chaque exécution doivent être
+ceux d'un processus seul sur la même grille, sinon la série est en erreur :
+ses mesures porteraient sur un calcul faux.
+"""
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+
+ICI = os.path.dirname(os.path.abspath(__file__))
+
+
+def decomposer(nb_processus):
+    """
+    Grille de processus P x Q la plus carrée possible, P >= Q, comme
+    MPI_Dims_create
+
+    Retourne: Le tuple (P, Q)
+    """
+
+    q = int(nb_processus ** 0.5)
+    while nb_processus % q:
+        q -= 1
+
+    return nb_processus // q, q
+
+
+def executer(args, nb_processus, largeur, hauteur, grille):
+    """
+    Exécuter la solution MPI sur une grille synthétique
+
+    Retourne: Le rapport JSON de l'exécution
+    """
+
+    with tempfile.TemporaryDirectory() as dossier:
+        rapport = os.path.join(dossier, "rapport.json")
+        commande = (args.mpirun.split() + ["-np", str(nb_processus)] +
+                    args.options_mpirun.split() +
+                    [os.path.abspath(args.executable),
+                     "-G", f"{largeur}x{hauteur}",
+                     "-g", f"{grille[0]}x{grille[1]}",
+                     "-i", str(args.iterations),
+                     "-H", str(args.halo),
+                     "-c", str(args.intervalle),
+                     "-R", rapport])
+
+        # resultat.png est écrit dans le dossier temporaire
+        subprocess.run(commande, cwd=dossier, check=True,
+                       stdout=subprocess.DEVNULL)
+
+        with open(rapport) as fichier:
+            return json.loads(fichier.readlines()[-1])
+
+
+def resultat(rapport):
+    """
+    Résultat du calcul d'un rapport, indépendant du découpage
+    """
+
+    return rapport["iterations"], rapport["t_min"], rapport["t_max"]
+
+
+def par_iteration(rapport, phase, mesure="max"):
+    """
+    Secondes d'une phase par itération calculée
+    """
+
+    return (rapport["phases"][phase][mesure] /
+            max(1, rapport["iterations_calculees"]))
+
+
+def afficher(mode, mesures):
+    """
+    Afficher le tableau d'efficacité d'une série de mesures, en millisecondes
+    par itération : en échelle forte, l'accélération est T1 / Tp et
+    l'efficacité T1 / (p Tp) ; en échelle faible, l'efficacité est T1 / Tp
+    et l'accélération p T1 / Tp. Le calcul est celui du processus le plus
+    lent, le halo et la réduction la moyenne des processus.
+    """
+
+    print(f"\nÉchelle {mode}")
+    print(f"{'proc.':>5} {'grille':>11} {'ms/itér.':>9} {'calcul':>8} "
+          f"{'halo':>8} {'réduc.':>8} {'déséq.':>7} {'accél.':>7} "
+          f"{'effic.':>7}")
+
+    reference = None
+    for rapport in mesures:
+        p = rapport["processus"]
+        temps = par_iteration(rapport, "convergence")
+        calcul = (par_iteration(rapport, "couleur_0") +
+                  par_iteration(rapport, "couleur_1"))
+
+        # La première mesure sert de référence, supposée parfaite
+        if reference is None:
+            reference = (temps, p)
+        if mode == "faible":
+            efficacite = reference[0] / temps
+        else:
+            efficacite = reference[0] * reference[1] / (temps * p)
+        grille = f"{rapport['largeur']}x{rapport['hauteur']}"
+
+        print(f"{p:>5} {grille:>11} {temps * 1e3:>9.3f} "
+              f"{calcul * 1e3:>8.3f} "
+              f"{par_iteration(rapport, 'halo', 'moyenne') * 1e3:>8.3f} "
+              f"{par_iteration(rapport, 'reduction', 'moyenne') * 1e3:>8.3f} "
+              f"{rapport['desequilibre']:>7.3f} {efficacite * p:>7.2f} "
+              f"{efficacite * 100:>6.1f}%")
+
+
+def main():
+    analyse = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    analyse.add_argument("--processus", default="1,2,4",
+                         help="nombres de processus (défaut 1,2,4)")
+    analyse.add_argument("--cote-fort", type=int, default=2048,
+                         help="côté de la grille en échelle forte")
+    analyse.add_argument("--cote-faible", type=int, default=512,
+                         help="côté du bloc de chaque processus en échelle "
+                              "faible")
+    analyse.add_argument("--iterations", type=int, default=200)
+    analyse.add_argument("--halo", type=int, default=1)
+    analyse.add_argument("--intervalle", type=int, default=1,
+                         help="itérations entre deux tests de convergence")
+    analyse.add_argument("--modes", default="forte,faible")
+    analyse.add_argument("--executable",
+                         default=os.path.join(ICI, "ecoulement"))
+    analyse.add_argument("--mpirun", default="mpirun")
+    analyse.add_argument("--options-mpirun", default="",
+                         help="par exemple \"--oversubscribe --bind-to core\"")
+    analyse.add_argument("--brut", default="echelonnement.json",
+                         help="rapports JSON de toutes les exécutions")
+    analyse.add_argument("--csv", default="echelonnement.csv",
+                         help="temps de chaque processus")
+    args = analyse.parse_args()
+
+    processus = [int(p) for p in args.processus.split(",")]
+    modes = args.modes.split(",")
+
+    # Résultat d'un processus seul, par taille de grille
+    references = {}
+
+    with open(args.brut, "a") as brut, open(args.csv, "w", newline="") as f:
+        rangs = csv.writer(f)
+        rangs.writerow(["mode", "processus", "rang", "calcul", "halo",
+                        "reduction"])
+
+        for mode in modes:
+            mesures = []
+            ecarts = []
+
+            for p in processus:
+                grille = decomposer(p)
+                if mode == "forte":
+                    largeur = hauteur = args.cote_fort
+                elif mode == "faible":
+                    largeur = args.cote_faible * grille[1]
+                    hauteur = args.cote_faible * grille[0]
+                else:
+                    sys.exit(f"Erreur: mode inconnu - {mode}")
+
+                print(f"{mode} : {p} processus, {largeur}x{hauteur}",
+                      file=sys.stderr)
+                rapport = executer(args, p, largeur, hauteur, grille)
+                rapport["mode"] = mode
+
+                # Sans processus seul dans la série, il est exécuté à part
+                taille = (largeur, hauteur)
+                if p == 1:
+                    references.setdefault(taille, resultat(rapport))
+                elif taille not in references:
+                    print(f"{mode} : référence, 1 processus, "
+                          f"{largeur}x{hauteur}", file=sys.stderr)
+                    references[taille] = resultat(
+                        executer(args, 1, largeur, hauteur, (1, 1)))
+                if resultat(rapport) != references[taille]:
+                    ecarts.append(f"{p} processus : itérations, t_min, t_max "
+                                  f"= {resultat(rapport)} au lieu de "
+                                  f"{references[taille]}")
+                brut.write(json.dumps(rapport) + "\n")
+                mesures.append(rapport)
+
+                for rang in range(p):
+                    rangs.writerow([
+                        mode, p, rang,
+                        rapport["calcul_par_processus"][rang],
+                        rapport["halo_par_processus"][rang],
+                        rapport["reduction_par_processus"][rang]])
+
+            afficher(mode, mesures)
+
+            if ecarts:
+                sys.exit(f"Erreur: échelle {mode}, résultat différent d'un "
+                         f"processus seul\n" + "\n".join(ecarts))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,12 +1,27 @@
 #include <algorithm>
 #include <array>
+#include <cerrno>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <getopt.h>
 #include <iostream>
 #include <mpi.h>
 #include <numeric>
+#include <new>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include <png.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -15,6 +30,21 @@ const ctc_t BRUIT = 6.4 / 256;  // 6.4 unités de la résolution de 8 bits
 const ctc_t SEUIL_CONVERGENCE = 0.5 / 256;  // 0.5 unité par pixel
 const unsigned int NB_MAX_ITER = 5000; // Limiter le temps de calcul
 
+// Les variations sont additionnées en virgule fixe, en unités de 2^-23 :
+// l'addition entière étant associative, la somme globale ne dépend ni du
+// découpage en blocs ni de l'ordre de MPI_Allreduce, et le nombre
+// d'itérations est le même quel que soit le nombre de processus
+typedef std::int64_t somme_t;
+const ctc_t ECHELLE_SOMME = 8388608.f;  // 2^23, exact en float
+
+/**
+ * Variation d'un point en virgule fixe, arrondie au plus proche
+ */
+inline somme_t quantifier(ctc_t delta_temp)
+{
+    return (somme_t)(std::abs(delta_temp) * ECHELLE_SOMME + 0.5f);
+}
+
 
 /**
  * Classe facilitant la lecture-écriture (Le) de fichiers PNG en RGB
@@ -56,6 +86,15 @@ public:
         }
     }
 
+    /**
+     * Donner les dimensions d'une image à remplir puis enregistrer
+     */
+    void dimensionner(png_uint_32 larg, png_uint_32 haut) {
+        entete.width = larg;
+        entete.height = haut;
+        resize(larg * haut);
+    }
+
     inline png_uint_32 largeur() const { return entete.width; }
     inline png_uint_32 hauteur() const { return entete.height; }
 
@@ -75,113 +114,691 @@ typedef struct {
 
 
 /**
- * Modèle de grille 2D de valeurs de chaleur, température et conduction
+ * Phases chronométrées par chaque processus, dans l'ordre du rapport.
+ * Les passes des deux couleurs du damier, l'attente des échanges de halo
+ * et la réduction de la convergence sont des parties de la convergence.
  */
-class ModeleCTC: public std::vector<CTC>
+enum Phase {
+    PHASE_LECTURE,        // PNG (premier processus) ou sauvegarde
+    PHASE_DISTRIBUTION,   // Blocs de pixels vers les processus
+    PHASE_CONVERSION,     // Pixels RGB vers triplets CTC
+    PHASE_CONVERGENCE,    // Boucle principale, sauvegardes comprises
+    PHASE_COULEUR_0,      // Passes de la couleur 0
+    PHASE_COULEUR_1,      // Passes de la couleur 1
+    PHASE_HALO,           // Attente des échanges de halo
+    PHASE_REDUCTION,      // MPI_Allreduce des variations
+    PHASE_MINMAX,         // Températures extrêmes
+    PHASE_COLORATION,     // Températures vers pixels RGB
+    PHASE_RASSEMBLEMENT,  // Blocs de pixels vers le premier processus
+    PHASE_ECRITURE,       // Compression et écriture du PNG
+    NB_PHASES
+};
+
+const char * const NOMS_PHASES[NB_PHASES] = {
+    "lecture", "distribution", "conversion", "convergence", "couleur_0",
+    "couleur_1", "halo", "reduction", "minmax", "coloration",
+    "rassemblement", "ecriture"
+};
+
+
+/**
+ * Indices [debut, fin) mis à jour par un processus selon une dimension
+ */
+struct Tranche {
+    std::size_t debut;
+    std::size_t fin;
+};
+
+/**
+ * Calculer la tranche d'un processus selon une dimension de la grille
+ * @param coord Coordonnée du processus selon cette dimension
+ * @param nb Nombre de processus selon cette dimension
+ * @param taille Taille de la grille complète selon cette dimension
+ * @param etendue Vrai pour inclure la marge de 1 pixel au début (premier
+ *                processus) ou à la fin (dernier processus)
+ */
+inline Tranche tranche(int coord, int nb, std::size_t taille, bool etendue)
+{
+    Tranche t;
+
+    t.debut = 1 + coord * (taille - 2) / nb;
+    t.fin = 1 + (coord + 1) * (taille - 2) / nb;
+
+    if (etendue && coord == 0)
+        t.debut = 0;
+    if (etendue && coord == nb - 1)
+        t.fin = taille;
+
+    return t;
+}
+
+
+/**
+ * Bloc de la grille mis à jour par un processus de la grille cartésienne
+ * @param comm Communicateur cartésien 2D
+ * @param rank Rang du processus dans comm
+ * @param largeur Largeur de la grille complète
+ * @param hauteur Hauteur de la grille complète
+ * @param etendue Vrai pour inclure les marges aux bords de la grille
+ * @param rangees Tranche de rangées du bloc
+ * @param colonnes Tranche de colonnes du bloc
+ */
+inline void bloc(MPI_Comm comm, int rank,
+                 std::size_t largeur, std::size_t hauteur, bool etendue,
+                 Tranche & rangees, Tranche & colonnes)
+{
+    int dims[2], periodes[2], coords[2];
+
+    MPI_Cart_get(comm, 2, dims, periodes, coords);
+    MPI_Cart_coords(comm, rank, 2, coords);
+
+    rangees = tranche(coords[0], dims[0], hauteur, etendue);
+    colonnes = tranche(coords[1], dims[1], largeur, etendue);
+}
+
+
+/**
+ * Répartition des processus d'un nœud sur ses processeurs
+ */
+enum Epinglage {
+    EPINGLAGE_AUCUN,
+    EPINGLAGE_PROCHE,   // Processeurs consécutifs : un socket après l'autre
+    EPINGLAGE_REPARTI   // Processeurs espacés : tous les sockets à la fois
+};
+
+/**
+ * Numéro du fil courant dans l'équipe OpenMP, 0 sans OpenMP
+ */
+inline int numero_fil()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Épingler chaque fil du processus courant sur un des processeurs qui lui
+ * sont permis, selon le rang du processus parmi ceux du même nœud. Les
+ * fils d'un processus occupent des processeurs consécutifs (proche) ou
+ * espacés dans sa part des processeurs (reparti). À épingler avant
+ * d'allouer la grille : chaque fil touche alors en premier ses rangées du
+ * bloc, qui sont placées sur le nœud NUMA de son processeur. Sans effet si
+ * le lanceur a déjà réduit les processeurs permis à un seul.
+ * @param mode Répartition des processus et de leurs fils
+ * @param nb_fils Nombre de fils OpenMP de chaque processus
+ * @return Faux si l'épinglage n'est pas possible sur ce système
+ */
+inline bool epingler_processus(Epinglage mode, int nb_fils)
+{
+    if (mode == EPINGLAGE_AUCUN)
+        return true;
+
+#ifdef __linux__
+    MPI_Comm noeud;
+    int local = 0, nb_locaux = 1;
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+                        MPI_INFO_NULL, &noeud);
+    MPI_Comm_rank(noeud, &local);
+    MPI_Comm_size(noeud, &nb_locaux);
+    MPI_Comm_free(&noeud);
+
+    cpu_set_t permis;
+    std::vector<int> processeurs;
+
+    if (sched_getaffinity(0, sizeof permis, &permis) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &permis))
+                processeurs.push_back(c);
+        }
+    }
+    if (processeurs.empty())
+        return false;
+
+    // Premier processeur du processus, puis écart entre ses fils
+    const std::size_t nb = processeurs.size();
+    const std::size_t premier = mode == EPINGLAGE_REPARTI ?
+        (std::size_t)local * nb / nb_locaux : (std::size_t)local * nb_fils;
+    const std::size_t ecart = mode == EPINGLAGE_REPARTI ?
+        std::max<std::size_t>(nb / nb_locaux / nb_fils, 1) : 1;
+    int echecs = 0;
+
+    // Sous Linux, sched_setaffinity(0, ...) n'épingle que le fil appelant
+    #pragma omp parallel num_threads(nb_fils) reduction(+: echecs)
+    {
+        cpu_set_t processeur;
+
+        CPU_ZERO(&processeur);
+        CPU_SET(processeurs[(premier + numero_fil() * ecart) % nb],
+                &processeur);
+        echecs += sched_setaffinity(0, sizeof processeur, &processeur) != 0;
+    }
+
+    return echecs == 0;
+#else
+    return false;
+#endif
+}
+
+
+/**
+ * Allocateur du bloc de la grille. Les éléments ne reçoivent pas de valeur
+ * initiale : la première écriture de chaque page (first touch), qui la
+ * place sur le nœud NUMA du fil qui l'écrit, revient ainsi au fil qui la
+ * calculera plutôt qu'au remplissage de zéros du fil principal.
+ */
+template <class T>
+struct AllocateurGrille {
+    typedef T value_type;
+
+    static const std::size_t ALIGNEMENT = 64;  // Ligne de cache
+
+    AllocateurGrille() {}
+    template <class U>
+    AllocateurGrille(const AllocateurGrille<U> &) {}
+
+    T * allocate(std::size_t n) {
+        void * p = NULL;
+
+        if (posix_memalign(&p, ALIGNEMENT, n * sizeof(T)))
+            throw std::bad_alloc();
+
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T * p, std::size_t) {
+        std::free(p);
+    }
+
+    /**
+     * Initialisation par défaut, sans valeur pour les types simples
+     */
+    template <class U>
+    void construct(U * p) {
+        ::new((void *)p) U;
+    }
+    template <class U, class... Arguments>
+    void construct(U * p, Arguments &&... arguments) {
+        ::new((void *)p) U(std::forward<Arguments>(arguments)...);
+    }
+};
+
+template <class T, class U>
+inline bool operator==(const AllocateurGrille<T> &, const AllocateurGrille<U> &)
+{
+    return true;
+}
+
+template <class T, class U>
+inline bool operator!=(const AllocateurGrille<T> &, const AllocateurGrille<U> &)
+{
+    return false;
+}
+
+
+/**
+ * Modèle de grille 2D de valeurs de chaleur, température et conduction.
+ * Chaque processus d'une grille cartésienne de processus ne conserve que
+ * son bloc et celui de son halo : rangées [r0, r1) et colonnes [c0, c1).
+ * Les accès se font avec les indices de la grille complète.
+ */
+class ModeleCTC: public std::vector<CTC, AllocateurGrille<CTC> >
 {
 public:
-    ModeleCTC(): larg(0), haut(0) {}
+    ModeleCTC(): larg(0), haut(0), r0(0), r1(0), c0(0), c1(0), larg_locale(0),
+        halo(1), etape(0), nb_fils(1), comm(MPI_COMM_NULL),
+        voisin_haut(MPI_PROC_NULL), voisin_bas(MPI_PROC_NULL),
+        voisin_gauche(MPI_PROC_NULL), voisin_droite(MPI_PROC_NULL),
+        type_colonnes(MPI_DATATYPE_NULL) {
+        rangees.debut = rangees.fin = colonnes.debut = colonnes.fin = 0;
+        std::fill(temps, temps + NB_PHASES, 0.);
+    }
+
+    virtual ~ModeleCTC() {
+        int termine;
+
+        MPI_Finalized(&termine);
+        if (!termine && type_colonnes != MPI_DATATYPE_NULL)
+            MPI_Type_free(&type_colonnes);
+    }
 
     /**
-     * Redimensionner la grille
+     * Découper la grille selon le communicateur cartésien et allouer
+     * le bloc du processus courant, incluant son halo
+     * @param largeur Largeur de la grille complète
+     * @param hauteur Hauteur de la grille complète
+     * @param cart Communicateur cartésien 2D non périodique
+     * @param profondeur Nombre d'itérations entre deux échanges de halo
      */
-    void redimensionner(std::size_t largeur, std::size_t hauteur) {
+    void decouper(std::size_t largeur, std::size_t hauteur,
+                  MPI_Comm cart, int profondeur) {
+        int rank;
+
+        MPI_Comm_rank(cart, &rank);
+        bloc(cart, rank, largeur, hauteur, false, rangees, colonnes);
+
         larg = largeur;
         haut = hauteur;
+        comm = cart;
+        halo = profondeur;
+        etape = 0;
 
-        resize(larg * haut);
+        // Voisins non périodiques, MPI_PROC_NULL aux bords
+        MPI_Cart_shift(comm, 0, 1, &voisin_haut, &voisin_bas);
+        MPI_Cart_shift(comm, 1, 1, &voisin_gauche, &voisin_droite);
+
+        const std::size_t epaisseur = epaisseur_halo();
+        r0 = (rangees.debut > epaisseur) ? rangees.debut - epaisseur : 0;
+        r1 = std::min(haut, rangees.fin + epaisseur);
+        c0 = (colonnes.debut > epaisseur) ? colonnes.debut - epaisseur : 0;
+        c1 = std::min(larg, colonnes.fin + epaisseur);
+        larg_locale = c1 - c0;
+
+        resize(larg_locale * (r1 - r0));
+        toucher();
+
+        // Colonnes du halo sur les rangées du processus courant, et sur
+        // les marges du haut et du bas de la grille qu'il détient : les
+        // coins du halo qu'elles touchent ne viennent d'aucun échange de
+        // rangées, et le calcul redondant du halo profond les lit
+        if (type_colonnes != MPI_DATATYPE_NULL)
+            MPI_Type_free(&type_colonnes);
+        MPI_Type_vector(fin_colonnes() - debut_colonnes(), 3 * epaisseur,
+            3 * larg_locale, MPI_FLOAT, &type_colonnes);
+        MPI_Type_commit(&type_colonnes);
     }
 
     /**
      * Accès à un triplet (Chaleur, Température, Conduction)
      */
     inline CTC& ctc(std::size_t rangee, std::size_t colonne) {
-        return at(rangee * larg + colonne);
+        return at((rangee - r0) * larg_locale + (colonne - c0));
     }
     inline const CTC& ctc(std::size_t rangee, std::size_t colonne) const {
-        return at(rangee * larg + colonne);
+        return at((rangee - r0) * larg_locale + (colonne - c0));
     }
 
     /**
      * Accès à une composante
      */
     inline ctc_t chaleur(std::size_t rangee, std::size_t colonne) const {
-        return at(rangee * larg + colonne).chaleur;
+        return ctc(rangee, colonne).chaleur;
     }
     inline ctc_t temperature(std::size_t rangee, std::size_t colonne) const {
-        return at(rangee * larg + colonne).temperature;
+        return ctc(rangee, colonne).temperature;
     }
     inline ctc_t conduction(std::size_t rangee, std::size_t colonne) const {
-        return at(rangee * larg + colonne).conduction;
+        return ctc(rangee, colonne).conduction;
     }
 
     inline std::size_t largeur() const { return larg; }
     inline std::size_t hauteur() const { return haut; }
 
     /**
-     * Effectuer une itération d'écoulement de chaleur sur toute la grille
-     * @return La différence de température moyenne
+     * Nombre de fils OpenMP qui se partagent le bloc du processus courant
+     */
+    inline int fils() const { return nb_fils; }
+    inline void fils(int n) { nb_fils = std::max(n, 1); }
+
+    /**
+     * Secondes cumulées par le processus courant dans une phase ; le
+     * modèle chronomètre lui-même les parties de l'itération
      */
-    ctc_t un_pas_de_temps(int rank, int size) {
-        ctc_t somme_delta = 0., world_delta;
-        std::size_t debut = 1 + rank * (haut - 2) / size;
-        std::size_t fin = 1 + (rank + 1) * (haut - 2) / size;
+    inline double & secondes(Phase phase) { return temps[phase]; }
+    inline const double * secondes() const { return temps; }
+
+    /**
+     * Épaisseur du halo en rangées et en colonnes : une seule si les
+     * échanges se font à chaque passe, sinon deux par itération puisque
+     * chaque itération fait deux passes (une par couleur) qui consomment
+     * chacune une rangée et une colonne de halo
+     */
+    inline std::size_t epaisseur_halo() const {
+        return (halo == 1) ? 1 : 2 * halo;
+    }
+
+    /**
+     * Effectuer une itération d'écoulement de chaleur sur toute la grille.
+     *
+     * Avec un halo de profondeur h > 1, les 2h rangées et colonnes voisines
+     * ne sont échangées qu'aux h itérations. Entre deux échanges, chaque
+     * passe recalcule de façon redondante la partie encore valide du halo,
+     * qui diminue d'une rangée et d'une colonne par passe. Avec h = 1,
+     * l'échange se fait à chaque passe, en parallèle du calcul de
+     * l'intérieur du bloc.
+     *
+     * Compilé avec OpenMP (make hybride), les fils du processus se
+     * partagent les rangées de chaque passe. Seul le fil principal appelle
+     * MPI (MPI_THREAD_FUNNELED).
+     *
+     * @param verifier Vrai pour calculer la différence de température
+     *                 moyenne globale (MPI_Allreduce)
+     * @return La différence de température moyenne, ou 0 si non vérifiée
+     */
+    ctc_t un_pas_de_temps(bool verifier) {
+        somme_t somme_delta = 0, world_delta = 0;
+
+        if (halo == 1)
+            somme_delta = un_pas_de_temps_pipeline();
+        else
+            somme_delta = un_pas_de_temps_halo();
+
+        // Calculer la différence totale
+        if (verifier) {
+            const double debut = MPI_Wtime();
+
+            MPI_Allreduce(&somme_delta, &world_delta, 1, MPI_INT64_T,
+                          MPI_SUM, comm);
+            temps[PHASE_REDUCTION] += MPI_Wtime() - debut;
+        }
+
+        return world_delta / ECHELLE_SOMME / (larg * haut);
+    }
+
+    /**
+     * Échanger le halo complet avec les quatre processus voisins :
+     * d'abord les colonnes, puis les rangées sur toute la largeur locale
+     * afin de propager aussi les coins du halo
+     */
+    void echanger_halo() {
+        const double debut = MPI_Wtime();
+        MPI_Request requetes[8];
+
+        debuter_echange_colonnes(requetes);
+        MPI_Waitall(4, requetes, MPI_STATUSES_IGNORE);
+
+        debuter_echange_rangees(c0, c1, requetes);
+        MPI_Waitall(4, requetes, MPI_STATUSES_IGNORE);
+        temps[PHASE_HALO] += MPI_Wtime() - debut;
+    }
+
+private:
+    /**
+     * Écrire une première fois le bloc, halo compris, avec la même
+     * répartition statique des rangées que les passes : chaque page est
+     * placée sur le nœud NUMA du fil qui la calculera. Avec -H 1, les
+     * rangées intérieures sont distribuées à la demande, et leurs pages
+     * sont seulement réparties entre les nœuds des fils.
+     */
+    void toucher() {
+        const long debut = r0, fin = r1;
+
+        #pragma omp parallel for schedule(static) num_threads(nb_fils)
+        for (long i = debut; i < fin; ++i) {
+            std::fill_n(data() + (i - debut) * larg_locale, larg_locale,
+                        CTC {0., 0., 0.});
+        }
+    }
+
+    /**
+     * Mettre à jour une couleur sur une rangée de la grille
+     * @param impair Couleur du damier à traiter
+     * @param i Rangée à traiter
+     * @param cmin Première colonne à traiter
+     * @param cmax Colonne suivant la dernière à traiter
+     * @return La somme des variations des points du processus courant,
+     *         en virgule fixe
+     */
+    somme_t rangee(int impair, std::size_t i,
+                   std::size_t cmin, std::size_t cmax) {
+        somme_t somme_delta = 0;
+        auto depart = ((i + cmin + impair) & 1);  // Damier
+        const bool interne = (i >= rangees.debut && i < rangees.fin);
+
+        for (auto j = cmin + depart; j < cmax; j += 2) {
+            ctc_t conduct = conduction(i, j);
+            ctc_t ancienne_temp = temperature(i, j);
+            ctc_t nouvelle_temp = std::max(chaleur(i, j), (
+                temperature(i - 1, j) +
+                temperature(i, j - 1) +
+                temperature(i, j + 1) +
+                temperature(i + 1, j) ) / 4 + BRUIT);
+            ctc_t delta_temp = conduct *
+                (nouvelle_temp - ancienne_temp);
+
+            ctc(i, j).temperature += delta_temp;
+
+            // Ne compter que les points du processus courant
+            if (interne && j >= colonnes.debut && j < colonnes.fin)
+                somme_delta += quantifier(delta_temp);
+        }
+
+        return somme_delta;
+    }
+
+    /**
+     * Mettre à jour une couleur sur un rectangle de la grille. Dans une
+     * région parallèle, les rangées sont partagées entre les fils, sans
+     * barrière à la fin.
+     * @param impair Couleur du damier à traiter
+     * @param rmin Première rangée à traiter
+     * @param rmax Rangée suivant la dernière à traiter
+     * @param cmin Première colonne à traiter
+     * @param cmax Colonne suivant la dernière à traiter
+     * @return La somme des variations des points du processus courant
+     *         traités par le fil appelant, en virgule fixe
+     */
+    somme_t passe(int impair, std::size_t rmin, std::size_t rmax,
+                  std::size_t cmin, std::size_t cmax) {
+        somme_t somme_delta = 0;
+
+        #pragma omp for schedule(static) nowait
+        for (std::size_t i = rmin; i < rmax; ++i)
+            somme_delta += rangee(impair, i, cmin, cmax);
+
+        return somme_delta;
+    }
+
+    /**
+     * Itération avec halo profond, échangé aux h itérations
+     * @return La somme des variations des points du processus courant,
+     *         en virgule fixe
+     */
+    somme_t un_pas_de_temps_halo() {
+        somme_t somme_delta = 0;
+        const long epaisseur = epaisseur_halo();
 
         // Converge plus vite si on traite en damier (une couleur à la fois)
+        #pragma omp parallel num_threads(nb_fils) reduction(+: somme_delta)
         for (auto impair = 0; impair < 2; ++impair) {
+            // Partie du halo encore valide après cette passe
+            const long marge = epaisseur - (2 * etape + impair + 1);
+            const double debut = MPI_Wtime();
+
             // Laisser faire la marge de 1 pixel
-            for (auto i = debut; i < fin; ++i) {
-                auto depart = (((i + 1) ^ impair) & 1);  // Damier
-
-                for (auto j = 1 + depart; j < larg - 1; j += 2) {
-                    ctc_t conduct = conduction(i, j);
-                    ctc_t ancienne_temp = temperature(i, j);
-                    ctc_t nouvelle_temp = std::max(chaleur(i, j), (
-                        temperature(i - 1, j) +
-                        temperature(i, j - 1) +
-                        temperature(i, j + 1) +
-                        temperature(i + 1, j) ) / 4 + BRUIT);
-                    ctc_t delta_temp = conduct *
-                        (nouvelle_temp - ancienne_temp);
-
-                    ctc(i, j).temperature += delta_temp;
-                    somme_delta += std::abs(delta_temp);
+            somme_delta += passe(impair,
+                std::max(1L, (long)rangees.debut - marge),
+                std::min((long)haut - 1, (long)rangees.fin + marge),
+                std::max(1L, (long)colonnes.debut - marge),
+                std::min((long)larg - 1, (long)colonnes.fin + marge));
+
+            // La couleur suivante lit celle-ci
+            #pragma omp barrier
+            #pragma omp master
+            temps[PHASE_COULEUR_0 + impair] += MPI_Wtime() - debut;
+        }
+
+        // Échanger le halo lorsqu'il est épuisé
+        if (++etape == halo) {
+            echanger_halo();
+            etape = 0;
+        }
+
+        return somme_delta;
+    }
+
+    /**
+     * Itération avec échange à chaque passe : le pourtour du bloc est
+     * calculé en premier, puis son envoi se fait pendant le calcul de
+     * l'intérieur du bloc. L'attente n'a lieu qu'avant la passe suivante,
+     * qui a besoin du halo reçu. Le stencil à cinq points n'a pas besoin
+     * des coins : les quatre échanges se font ensemble.
+     *
+     * Avec plusieurs fils, les rangées de l'intérieur sont distribuées à la
+     * demande. Le fil principal, seul à appeler MPI, fait progresser les
+     * échanges (MPI_Testall) entre deux de ses rangées, et les autres fils
+     * prennent le reste de sa part.
+     * @return La somme des variations des points du processus courant,
+     *         en virgule fixe
+     */
+    somme_t un_pas_de_temps_pipeline() {
+        somme_t somme_delta = 0;
+        const std::size_t rd = rangees.debut, rf = rangees.fin;
+        const std::size_t cd = colonnes.debut, cf = colonnes.fin;
+        MPI_Request requetes[8];
+
+        #pragma omp parallel num_threads(nb_fils) reduction(+: somme_delta)
+        for (auto impair = 0; impair < 2; ++impair) {
+            const double debut = MPI_Wtime();
+            int recu = 0;
+
+            // Pourtour du bloc, à envoyer aux voisins
+            somme_delta += passe(impair, rd, rd + 1, cd, cf);
+            if (rf - 1 > rd)
+                somme_delta += passe(impair, rf - 1, rf, cd, cf);
+            if (rf - 1 > rd + 1) {
+                somme_delta += passe(impair, rd + 1, rf - 1, cd, cd + 1);
+                if (cf - 1 > cd)
+                    somme_delta += passe(impair, rd + 1, rf - 1, cf - 1, cf);
+            }
+
+            #pragma omp barrier
+            #pragma omp master
+            {
+                debuter_echange_colonnes(requetes);
+                debuter_echange_rangees(cd, cf, requetes + 4);
+            }
+
+            // Intérieur du bloc pendant les communications
+            if (rf - 1 > rd + 1 && cf - 1 > cd + 1) {
+                #pragma omp for schedule(dynamic) nowait
+                for (std::size_t i = rd + 1; i < rf - 1; ++i) {
+                    somme_delta += rangee(impair, i, cd + 1, cf - 1);
+
+                    if (!recu && numero_fil() == 0)
+                        MPI_Testall(8, requetes, &recu, MPI_STATUSES_IGNORE);
                 }
             }
+
+            #pragma omp master
+            {
+                const double attente = MPI_Wtime();
+
+                MPI_Waitall(8, requetes, MPI_STATUSES_IGNORE);
+                temps[PHASE_COULEUR_0 + impair] += attente - debut;
+                temps[PHASE_HALO] += MPI_Wtime() - attente;
+            }
+
+            // La passe suivante a besoin du halo reçu
+            #pragma omp barrier
         }
 
+        return somme_delta;
+    }
 
-        // Envoyer notre ligne du haut et recevoir celle du voisin
-        MPI_Request envoi_haut, recep_haut;
-        MPI_Isend(&ctc(debut, 0), 3 * larg, MPI_FLOAT,
-            (rank + size - 1) % size, 123, MPI_COMM_WORLD, &envoi_haut);
-        MPI_Irecv(&ctc(fin, 0), 3 * larg, MPI_FLOAT,
-            (rank + size + 1) % size, 123, MPI_COMM_WORLD, &recep_haut);
+    /**
+     * Lancer l'échange des rangées du halo avec les voisins du haut et
+     * du bas
+     * @param cmin Première colonne à échanger
+     * @param cmax Colonne suivant la dernière à échanger
+     * @param requetes Les quatre requêtes à compléter
+     */
+    void debuter_echange_rangees(std::size_t cmin, std::size_t cmax,
+                                 MPI_Request requetes[4]) {
+        const std::size_t epaisseur = epaisseur_halo();
+        const std::size_t rd = rangees.debut, rf = rangees.fin;
+        MPI_Datatype type_rangees;
 
-        // Envoyer notre ligne du bas et recevoir celle du voisin
-        MPI_Request envoi_bas, recep_bas;
-        MPI_Isend(&ctc(fin - 1, 0), 3 * larg, MPI_FLOAT,
-            (rank + size + 1) % size, 789, MPI_COMM_WORLD, &envoi_bas);
-        MPI_Irecv(&ctc(debut - 1, 0), 3 * larg, MPI_FLOAT,
-            (rank + size - 1) % size, 789, MPI_COMM_WORLD, &recep_bas);
+        // Les rangées sont séparées par la largeur locale
+        MPI_Type_vector(epaisseur, 3 * (cmax - cmin), 3 * larg_locale,
+            MPI_FLOAT, &type_rangees);
+        MPI_Type_commit(&type_rangees);
 
-        // Calculer la différence totale
-        MPI_Allreduce(&somme_delta, &world_delta, 1, MPI_FLOAT,
-                      MPI_SUM, MPI_COMM_WORLD);
+        std::fill(requetes, requetes + 4, MPI_REQUEST_NULL);
 
-        // Compléter les envois
-        MPI_Status etat;
-        MPI_Wait(&envoi_haut, &etat);
-        MPI_Wait(&recep_haut, &etat);
-        MPI_Wait(&envoi_bas, &etat);
-        MPI_Wait(&recep_bas, &etat);
+        if (voisin_haut != MPI_PROC_NULL) {
+            // Envoyer nos rangées du haut et recevoir celles du voisin
+            MPI_Isend(&ctc(rd, cmin), 1, type_rangees,
+                voisin_haut, 123, comm, &requetes[0]);
+            MPI_Irecv(&ctc(rd - epaisseur, cmin), 1, type_rangees,
+                voisin_haut, 789, comm, &requetes[1]);
+        }
+
+        if (voisin_bas != MPI_PROC_NULL) {
+            // Envoyer nos rangées du bas et recevoir celles du voisin
+            MPI_Isend(&ctc(rf - epaisseur, cmin), 1, type_rangees,
+                voisin_bas, 789, comm, &requetes[2]);
+            MPI_Irecv(&ctc(rf, cmin), 1, type_rangees,
+                voisin_bas, 123, comm, &requetes[3]);
+        }
 
-        return world_delta / (larg * haut);
+        // Libéré par MPI lorsque les communications seront terminées
+        MPI_Type_free(&type_rangees);
     }
 
-private:
-    std::size_t larg;
-    std::size_t haut;
+    /**
+     * Rangées des colonnes échangées : celles du processus courant,
+     * étendues aux marges de la grille sans voisin du haut ou du bas
+     */
+    inline std::size_t debut_colonnes() const {
+        return voisin_haut == MPI_PROC_NULL ? r0 : rangees.debut;
+    }
+    inline std::size_t fin_colonnes() const {
+        return voisin_bas == MPI_PROC_NULL ? r1 : rangees.fin;
+    }
+
+    /**
+     * Lancer l'échange des colonnes du halo avec les voisins de gauche et
+     * de droite, sur les rangées de debut_colonnes() à fin_colonnes()
+     * @param requetes Les quatre requêtes à compléter
+     */
+    void debuter_echange_colonnes(MPI_Request requetes[4]) {
+        const std::size_t epaisseur = epaisseur_halo();
+        const std::size_t rd = debut_colonnes();
+        const std::size_t cd = colonnes.debut, cf = colonnes.fin;
+
+        std::fill(requetes, requetes + 4, MPI_REQUEST_NULL);
+
+        if (voisin_gauche != MPI_PROC_NULL) {
+            // Envoyer nos colonnes de gauche et recevoir celles du voisin
+            MPI_Isend(&ctc(rd, cd), 1, type_colonnes,
+                voisin_gauche, 321, comm, &requetes[0]);
+            MPI_Irecv(&ctc(rd, cd - epaisseur), 1, type_colonnes,
+                voisin_gauche, 987, comm, &requetes[1]);
+        }
+
+        if (voisin_droite != MPI_PROC_NULL) {
+            // Envoyer nos colonnes de droite et recevoir celles du voisin
+            MPI_Isend(&ctc(rd, cf - epaisseur), 1, type_colonnes,
+                voisin_droite, 987, comm, &requetes[2]);
+            MPI_Irecv(&ctc(rd, cf), 1, type_colonnes,
+                voisin_droite, 321, comm, &requetes[3]);
+        }
+    }
+
+    std::size_t larg;         // Largeur de la grille complète
+    std::size_t haut;         // Hauteur de la grille complète
+    std::size_t r0, r1;       // Rangées locales, incluant le halo
+    std::size_t c0, c1;       // Colonnes locales, incluant le halo
+    std::size_t larg_locale;  // c1 - c0
+
+    // Découpage entre les processus
+    Tranche rangees;    // Rangées du processus courant
+    Tranche colonnes;   // Colonnes du processus courant
+    int halo;           // Nombre d'itérations entre deux échanges
+    int etape;          // Itérations faites depuis le dernier échange
+    int nb_fils;        // Fils OpenMP du processus courant
+
+    double temps[NB_PHASES];  // Secondes cumulées par phase
+
+    MPI_Comm comm;
+    int voisin_haut;
+    int voisin_bas;
+    int voisin_gauche;
+    int voisin_droite;
+    MPI_Datatype type_colonnes;
 };
 
 
@@ -208,8 +825,8 @@ png_color normaliser_couleur(ctc_t temp, ctc_t t_min, ctc_t t_max)
     }};
 
     // Calcul itératif de la courbe de Bézier dans l'espace des couleurs
-    for (auto iter = 1; iter < couleurs.size(); ++iter) {
-        for (auto i = 0; i < couleurs.size() - iter; ++i) {
+    for (std::size_t iter = 1; iter < couleurs.size(); ++iter) {
+        for (std::size_t i = 0; i < couleurs.size() - iter; ++i) {
             couleurs[i][0] += t * (couleurs[i + 1][0] - couleurs[i][0]);
             couleurs[i][1] += t * (couleurs[i + 1][1] - couleurs[i][1]);
             couleurs[i][2] += t * (couleurs[i + 1][2] - couleurs[i][2]);
@@ -224,104 +841,884 @@ png_color normaliser_couleur(ctc_t temp, ctc_t t_min, ctc_t t_max)
 }
 
 
+/**
+ * Distribuer les blocs de l'image du premier processus entre les processus
+ * de la grille cartésienne, ou les rassembler dans cette image.
+ * Un type MPI sous-tableau (subarray) décrit chaque bloc de l'image, ce qui
+ * évite de copier les blocs dans un tampon intermédiaire.
+ * @param png Image complète, utilisée par le premier processus seulement
+ * @param pixels Bloc du processus courant, marges incluses
+ * @param comm Communicateur cartésien 2D
+ * @param largeur Largeur de la grille complète
+ * @param hauteur Hauteur de la grille complète
+ * @param distribuer Vrai pour distribuer, faux pour rassembler
+ */
+void echanger_pixels(LePNG & png, std::vector<png_color> & pixels,
+                     MPI_Comm comm, std::size_t largeur, std::size_t hauteur,
+                     bool distribuer)
+{
+    int rank, size;
+    MPI_Datatype type_pixel;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    MPI_Type_contiguous(3, MPI_BYTE, &type_pixel);
+    MPI_Type_commit(&type_pixel);
+
+    std::vector<int> comptes_png(size, 0), comptes_bloc(size, 0);
+    std::vector<int> deplacements(size, 0);
+    std::vector<MPI_Datatype> types_png(size, type_pixel);
+    std::vector<MPI_Datatype> types_bloc(size, type_pixel);
+
+    if (rank == 0) {
+        for (int r = 0; r < size; ++r) {
+            Tranche rangees, colonnes;
+            bloc(comm, r, largeur, hauteur, true, rangees, colonnes);
+
+            int tailles[2] = {(int)hauteur, (int)largeur};
+            int sous_tailles[2] = {
+                (int)(rangees.fin - rangees.debut),
+                (int)(colonnes.fin - colonnes.debut)
+            };
+            int debuts[2] = {(int)rangees.debut, (int)colonnes.debut};
+
+            MPI_Type_create_subarray(2, tailles, sous_tailles, debuts,
+                MPI_ORDER_C, type_pixel, &types_png[r]);
+            MPI_Type_commit(&types_png[r]);
+            comptes_png[r] = 1;
+        }
+    }
+    comptes_bloc[0] = pixels.size();
+
+    if (distribuer) {
+        MPI_Alltoallw(png.data(), comptes_png.data(), deplacements.data(),
+            types_png.data(), pixels.data(), comptes_bloc.data(),
+            deplacements.data(), types_bloc.data(), comm);
+    }
+    else {
+        MPI_Alltoallw(pixels.data(), comptes_bloc.data(), deplacements.data(),
+            types_bloc.data(), png.data(), comptes_png.data(),
+            deplacements.data(), types_png.data(), comm);
+    }
+
+    if (rank == 0) {
+        for (int r = 0; r < size; ++r)
+            MPI_Type_free(&types_png[r]);
+    }
+    MPI_Type_free(&type_pixel);
+}
+
+
+/**
+ * En-tête d'un fichier de sauvegarde, suivi des plans de chaleur, de
+ * température et de conduction de la grille complète. Le format est celui
+ * de la version séquentielle : une sauvegarde de l'une se reprend avec
+ * l'autre, quel que soit le nombre de processus.
+ */
+struct EnteteSauvegarde {
+    char signature[8];        // SIGNATURE_SAUVEGARDE
+    std::uint32_t taille_ctc; // sizeof(ctc_t) des plans
+    std::uint32_t largeur;
+    std::uint32_t hauteur;
+    std::uint32_t nb_iter;    // Itérations effectuées
+    double delta_temp;        // Ajustement moyen de la dernière itération
+    double bruit;
+    double seuil_convergence;
+    std::uint32_t nb_max_iter;
+    std::uint32_t reserve[3];
+};
+
+static_assert(sizeof(EnteteSauvegarde) == 64,
+              "En-tête de sauvegarde de 64 octets");
+
+const char SIGNATURE_SAUVEGARDE[8] = {'C', 'T', 'C', 'S', 'A', 'U', 'V', '1'};
+
+
+/**
+ * Vue d'un processus sur les plans d'une sauvegarde : son bloc, marges
+ * incluses, dans chacun des trois plans
+ * @param comm Communicateur cartésien 2D
+ * @param largeur Largeur de la grille complète
+ * @param hauteur Hauteur de la grille complète
+ * @param rangees Tranche de rangées du bloc
+ * @param colonnes Tranche de colonnes du bloc
+ * @return Type MPI à libérer par l'appelant
+ */
+MPI_Datatype type_bloc_sauvegarde(std::size_t largeur, std::size_t hauteur,
+                                  const Tranche & rangees,
+                                  const Tranche & colonnes)
+{
+    MPI_Datatype type;
+    int tailles[3] = {3, (int)hauteur, (int)largeur};
+    int sous_tailles[3] = {
+        3,
+        (int)(rangees.fin - rangees.debut),
+        (int)(colonnes.fin - colonnes.debut)
+    };
+    int debuts[3] = {0, (int)rangees.debut, (int)colonnes.debut};
+
+    MPI_Type_create_subarray(3, tailles, sous_tailles, debuts,
+        MPI_ORDER_C, MPI_FLOAT, &type);
+    MPI_Type_commit(&type);
+
+    return type;
+}
+
+/**
+ * Sauvegarder l'état du calcul. Chaque processus écrit son bloc des trois
+ * plans par une écriture collective MPI-IO, sans passer par le premier
+ * processus, qui n'écrit que l'en-tête. Le fichier est écrit sous un nom
+ * temporaire puis renommé une fois que tous les processus ont réussi.
+ * @param nom_fichier Fichier de sauvegarde
+ * @param carte Modèle du processus courant
+ * @param comm Communicateur cartésien 2D
+ * @param nb_iter Itérations effectuées
+ * @param delta_temp Ajustement moyen de la dernière itération vérifiée
+ * @param nb_max_iter Limite du nombre d'itérations du calcul
+ * @return Faux si l'écriture a échoué, avec un message d'erreur affiché
+ */
+bool sauvegarder(const std::string & nom_fichier, const ModeleCTC & carte,
+                 MPI_Comm comm, unsigned int nb_iter, ctc_t delta_temp,
+                 unsigned int nb_max_iter)
+{
+    const std::size_t larg = carte.largeur(), haut = carte.hauteur();
+    const std::string temporaire = nom_fichier + ".tmp";
+    Tranche rangees, colonnes;
+    int rank;
+
+    MPI_Comm_rank(comm, &rank);
+    bloc(comm, rank, larg, haut, true, rangees, colonnes);
+
+    // Plans du bloc, dans l'ordre du fichier
+    const std::size_t points =
+        (rangees.fin - rangees.debut) * (colonnes.fin - colonnes.debut);
+    std::vector<ctc_t> plans(3 * points);
+    std::size_t k = 0;
+
+    for (auto i = rangees.debut; i < rangees.fin; ++i) {
+        for (auto j = colonnes.debut; j < colonnes.fin; ++j, ++k) {
+            plans[k] = carte.chaleur(i, j);
+            plans[points + k] = carte.temperature(i, j);
+            plans[2 * points + k] = carte.conduction(i, j);
+        }
+    }
+
+    MPI_File fichier;
+    int reussi = MPI_File_open(comm, temporaire.c_str(),
+        MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fichier)
+        == MPI_SUCCESS;
+
+    if (reussi) {
+        MPI_File_set_size(fichier, sizeof(EnteteSauvegarde) +
+            3 * larg * haut * sizeof(ctc_t));
+
+        if (rank == 0) {
+            EnteteSauvegarde entete;
+
+            memset(&entete, 0, sizeof entete);
+            memcpy(entete.signature, SIGNATURE_SAUVEGARDE,
+                   sizeof entete.signature);
+            entete.taille_ctc = sizeof(ctc_t);
+            entete.largeur = larg;
+            entete.hauteur = haut;
+            entete.nb_iter = nb_iter;
+            entete.delta_temp = delta_temp;
+            entete.bruit = BRUIT;
+            entete.seuil_convergence = SEUIL_CONVERGENCE;
+            entete.nb_max_iter = nb_max_iter;
+
+            reussi = MPI_File_write_at(fichier, 0, &entete, sizeof entete,
+                MPI_BYTE, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+        }
+
+        MPI_Datatype type = type_bloc_sauvegarde(larg, haut,
+                                                 rangees, colonnes);
+
+        MPI_File_set_view(fichier, sizeof(EnteteSauvegarde), MPI_FLOAT,
+            type, "native", MPI_INFO_NULL);
+        if (MPI_File_write_all(fichier, plans.data(), plans.size(),
+                MPI_FLOAT, MPI_STATUS_IGNORE) != MPI_SUCCESS)
+            reussi = 0;
+
+        MPI_File_close(&fichier);
+        MPI_Type_free(&type);
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &reussi, 1, MPI_INT, MPI_LAND, comm);
+
+    if (rank == 0) {
+        if (reussi && std::rename(temporaire.c_str(), nom_fichier.c_str()))
+            reussi = 0;
+        if (!reussi) {
+            std::cerr << "Erreur: " << nom_fichier
+                << " - sauvegarde impossible" << std::endl;
+            std::remove(temporaire.c_str());
+        }
+    }
+
+    return reussi;
+}
+
+/**
+ * Ouvrir une sauvegarde par tous les processus et en vérifier l'en-tête
+ * @param nom_fichier Fichier de sauvegarde
+ * @param comm Communicateur de tous les processus
+ * @param fichier Fichier ouvert, à passer à reprendre()
+ * @param entete En-tête lu
+ * @return Un message d'erreur, vide si la sauvegarde est utilisable
+ */
+std::string ouvrir_sauvegarde(const std::string & nom_fichier, MPI_Comm comm,
+                              MPI_File & fichier, EnteteSauvegarde & entete)
+{
+    MPI_Offset taille;
+
+    if (MPI_File_open(comm, nom_fichier.c_str(), MPI_MODE_RDONLY,
+                      MPI_INFO_NULL, &fichier) != MPI_SUCCESS)
+        return nom_fichier + " - ouverture impossible";
+
+    MPI_File_get_size(fichier, &taille);
+    memset(&entete, 0, sizeof entete);
+    if (taille >= (MPI_Offset)sizeof entete) {
+        MPI_File_read_at_all(fichier, 0, &entete, sizeof entete, MPI_BYTE,
+            MPI_STATUS_IGNORE);
+    }
+
+    std::string message;
+
+    if (memcmp(entete.signature, SIGNATURE_SAUVEGARDE,
+               sizeof entete.signature))
+        message = nom_fichier + " - signature de sauvegarde invalide";
+    else if (entete.taille_ctc != sizeof(ctc_t))
+        message = nom_fichier + " - plans de " +
+            std::to_string(entete.taille_ctc) + " octets par valeur";
+    else if (taille != (MPI_Offset)(sizeof entete + 3 * sizeof(ctc_t) *
+                 (std::size_t)entete.largeur * entete.hauteur))
+        message = nom_fichier + " - sauvegarde tronquée";
+
+    if (!message.empty())
+        MPI_File_close(&fichier);
+
+    return message;
+}
+
+/**
+ * Remplir le bloc du processus courant depuis une sauvegarde ouverte,
+ * par une lecture collective MPI-IO, puis fermer le fichier
+ * @param fichier Fichier ouvert par ouvrir_sauvegarde()
+ * @param carte Modèle déjà découpé selon la grille de la sauvegarde
+ * @param comm Communicateur cartésien 2D
+ */
+void reprendre(MPI_File & fichier, ModeleCTC & carte, MPI_Comm comm)
+{
+    const std::size_t larg = carte.largeur(), haut = carte.hauteur();
+    Tranche rangees, colonnes;
+    int rank;
+
+    MPI_Comm_rank(comm, &rank);
+    bloc(comm, rank, larg, haut, true, rangees, colonnes);
+
+    const std::size_t points =
+        (rangees.fin - rangees.debut) * (colonnes.fin - colonnes.debut);
+    std::vector<ctc_t> plans(3 * points);
+    MPI_Datatype type = type_bloc_sauvegarde(larg, haut, rangees, colonnes);
+
+    MPI_File_set_view(fichier, sizeof(EnteteSauvegarde), MPI_FLOAT, type,
+        "native", MPI_INFO_NULL);
+    MPI_File_read_all(fichier, plans.data(), plans.size(), MPI_FLOAT,
+        MPI_STATUS_IGNORE);
+    MPI_File_close(&fichier);
+    MPI_Type_free(&type);
+
+    std::size_t k = 0;
+
+    for (auto i = rangees.debut; i < rangees.fin; ++i) {
+        for (auto j = colonnes.debut; j < colonnes.fin; ++j, ++k) {
+            carte.ctc(i, j) = CTC {
+                plans[k], plans[points + k], plans[2 * points + k]
+            };
+        }
+    }
+}
+
+
+/**
+ * Valeur pseudo-aléatoire de [0, 1) propre à un tirage (splitmix64) : un
+ * point de la grille synthétique ne dépend que de ses coordonnées, quel
+ * que soit le découpage entre les processus
+ */
+inline double tirage(std::uint64_t k)
+{
+    k += 0x9e3779b97f4a7c15ULL;
+    k = (k ^ (k >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    k = (k ^ (k >> 27)) * 0x94d049bb133111ebULL;
+    k ^= k >> 31;
+
+    return (k >> 11) * (1. / (1ULL << 53));
+}
+
+/**
+ * Remplir le bloc du processus courant d'une grille synthétique :
+ * conduction uniforme entre 0 et 1, une source de chaleur de 128 à 255
+ * degrés pour mille points, et 20 degrés ailleurs
+ * @param carte Modèle découpé du processus courant
+ * @param rangees Tranche de rangées du bloc, marges incluses
+ * @param colonnes Tranche de colonnes du bloc, marges incluses
+ */
+void generer(ModeleCTC & carte, const Tranche & rangees,
+             const Tranche & colonnes)
+{
+    for (auto i = rangees.debut; i < rangees.fin; ++i) {
+        for (auto j = colonnes.debut; j < colonnes.fin; ++j) {
+            const std::uint64_t k = 3 * (i * carte.largeur() + j);
+            const bool source = tirage(k) < 0.001;
+            const ctc_t chaleur = source ? 128 + 127 * tirage(k + 1) : 0;
+
+            carte.ctc(i, j) = CTC {
+                chaleur,
+                source ? chaleur : ctc_t(20),
+                (ctc_t)tirage(k + 2)
+            };
+        }
+    }
+}
+
+
+/**
+ * Écrire une chaîne JSON entre guillemets, échappée
+ */
+void ecrire_chaine_json(std::ostream & flux, const std::string & s)
+{
+    flux << '"';
+    for (const char c : s) {
+        if (c == '"' || c == '\\')
+            flux << '\\' << c;
+        else if ((unsigned char)c < 0x20) {
+            char code[8];
+
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            flux << code;
+        }
+        else
+            flux << c;
+    }
+    flux << '"';
+}
+
+/**
+ * Bilan d'un calcul, pour le rapport
+ */
+struct Bilan {
+    std::string entree;              // Image ou sauvegarde initiale
+    unsigned int nb_iter;            // Itérations au total, reprise incluse
+    unsigned int nb_iter_calculees;  // Itérations de cette exécution
+    ctc_t delta_temp;
+    ctc_t t_min;
+    ctc_t t_max;
+    double total;                    // Secondes du processus courant
+};
+
+/**
+ * Ajouter le rapport JSON du calcul au fichier nom_rapport (- pour la
+ * sortie standard), en un objet par ligne : pour chaque phase, les
+ * secondes minimale, moyenne et maximale parmi les processus, le débit de
+ * la boucle principale, puis le temps de calcul, d'attente du halo et de
+ * réduction de chaque processus, qui mesurent le déséquilibre de charge.
+ * Appel collectif ; seul le premier processus écrit.
+ * @param nom_rapport Fichier du rapport
+ * @param carte Modèle du processus courant, avec ses chronomètres
+ * @param comm Communicateur cartésien 2D
+ * @param grille Nombre de processus par rangée et par colonne
+ * @param halo Nombre d'itérations entre deux échanges de halo
+ * @param bilan Résultats du calcul
+ */
+void rapporter(const std::string & nom_rapport, const ModeleCTC & carte,
+               MPI_Comm comm, const int grille[2], int halo,
+               const Bilan & bilan)
+{
+    const int nb_valeurs = NB_PHASES + 1;
+    int rank, size;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    std::vector<double> valeurs(carte.secondes(),
+                                carte.secondes() + NB_PHASES);
+    std::vector<double> toutes(rank == 0 ? size * nb_valeurs : 0);
+
+    valeurs.push_back(bilan.total);
+    MPI_Gather(valeurs.data(), nb_valeurs, MPI_DOUBLE, toutes.data(),
+               nb_valeurs, MPI_DOUBLE, 0, comm);
+
+    if (rank != 0)
+        return;
+
+    std::ofstream fichier;
+    std::ostream * flux = &std::cout;
+
+    if (nom_rapport != "-") {
+        fichier.open(nom_rapport, std::ios::app);
+        if (!fichier) {
+            std::cerr << "Erreur: " << nom_rapport << " - "
+                << std::strerror(errno) << std::endl;
+            return;
+        }
+        flux = &fichier;
+    }
+
+    // Valeur d'une phase pour un processus
+    auto valeur = [&](int r, int phase) {
+        return toutes[r * nb_valeurs + phase];
+    };
+    auto maximum = [&](int phase) {
+        double m = 0.;
+        for (int r = 0; r < size; ++r)
+            m = std::max(m, valeur(r, phase));
+        return m;
+    };
+
+    const double convergence = maximum(PHASE_CONVERGENCE);
+    const double points = (double)(carte.largeur() - 2) *
+        (carte.hauteur() - 2);
+    const double points_par_seconde = convergence > 0 ?
+        points * bilan.nb_iter_calculees / convergence : 0.;
+    const std::size_t octets_par_point = 4 * sizeof(ctc_t);
+    double somme_calcul = 0., max_calcul = 0.;
+
+    for (int r = 0; r < size; ++r) {
+        const double calcul =
+            valeur(r, PHASE_COULEUR_0) + valeur(r, PHASE_COULEUR_1);
+
+        somme_calcul += calcul;
+        max_calcul = std::max(max_calcul, calcul);
+    }
+
+    flux->precision(9);
+    *flux << "{\"entree\": ";
+    ecrire_chaine_json(*flux, bilan.entree);
+    *flux << ", \"modele\": \"mpi\", \"processus\": " << size
+        << ", \"fils\": " << carte.fils()
+        << ", \"grille\": [" << grille[0] << ", " << grille[1] << "]"
+        << ", \"halo\": " << halo
+        << ", \"largeur\": " << carte.largeur()
+        << ", \"hauteur\": " << carte.hauteur()
+        << ", \"iterations\": " << bilan.nb_iter
+        << ", \"iterations_calculees\": " << bilan.nb_iter_calculees
+        << ", \"ajustement_moyen\": " << bilan.delta_temp * 256
+        << ", \"t_min\": " << bilan.t_min
+        << ", \"t_max\": " << bilan.t_max
+        << ", \"phases\": {";
+    for (int p = 0; p < NB_PHASES; ++p) {
+        double somme = 0., min = valeur(0, p);
+
+        for (int r = 0; r < size; ++r) {
+            somme += valeur(r, p);
+            min = std::min(min, valeur(r, p));
+        }
+        *flux << (p ? ", \"" : "\"") << NOMS_PHASES[p] << "\": {\"min\": "
+            << min << ", \"moyenne\": " << somme / size
+            << ", \"max\": " << maximum(p) << "}";
+    }
+    *flux << "}, \"total\": " << maximum(NB_PHASES)
+        << ", \"points_par_seconde\": " << points_par_seconde
+        << ", \"octets_par_point\": " << octets_par_point
+        << ", \"go_par_seconde\": "
+        << points_par_seconde * octets_par_point / 1e9
+        << ", \"desequilibre\": "
+        << (somme_calcul > 0 ? max_calcul * size / somme_calcul : 1.)
+        << ", \"calcul_par_processus\": [";
+    for (int r = 0; r < size; ++r) {
+        *flux << (r ? ", " : "")
+            << valeur(r, PHASE_COULEUR_0) + valeur(r, PHASE_COULEUR_1);
+    }
+    *flux << "], \"halo_par_processus\": [";
+    for (int r = 0; r < size; ++r)
+        *flux << (r ? ", " : "") << valeur(r, PHASE_HALO);
+    *flux << "], \"reduction_par_processus\": [";
+    for (int r = 0; r < size; ++r)
+        *flux << (r ? ", " : "") << valeur(r, PHASE_REDUCTION);
+    *flux << "]}" << std::endl;
+}
+
+
+/**
+ * Afficher la syntaxe d'appel du programme
+ */
+void usage(const char * programme)
+{
+    std::cerr << "Usage: " << programme << " [options] fichier.png\n"
+        << "       " << programme << " [options] -r sauvegarde.ctc\n"
+        << "       " << programme << " [options] -G LxH\n"
+        << "Options:\n"
+        << "  -c, --intervalle N  Tester la convergence aux N itérations\n"
+        << "  -H, --halo H        Échanger un halo de 2H rangées\n"
+        << "                      aux H itérations (défaut : une rangée\n"
+        << "                      à chaque passe, pendant le calcul)\n"
+        << "  -g, --grille PxQ    Grille de P rangées et Q colonnes\n"
+        << "                      de processus (défaut : MPI_Dims_create)\n"
+        << "  -S, --sauvegarde F  Sauvegarder l'état du calcul dans F\n"
+        << "                      à la fin\n"
+        << "  -P, --periode N     Sauvegarder aussi toutes les N itérations\n"
+        << "  -r, --reprise F     Reprendre le calcul d'une sauvegarde\n"
+        << "  -R, --rapport F     Ajouter à F (- pour la sortie standard)\n"
+        << "                      la durée des phases par processus et\n"
+        << "                      le débit du calcul, en JSON\n"
+        << "  -G, --generer LxH   Calculer une grille synthétique de L x H\n"
+        << "                      points au lieu d'une image, générée par\n"
+        << "                      chaque processus (mesures d'échelle)\n"
+        << "  -i, --iterations N  Nombre maximal d'itérations (défaut 5000)\n"
+        << "  -t, --fils N        Fils OpenMP par processus (make hybride,\n"
+        << "                      défaut : OMP_NUM_THREADS)\n"
+        << "  -B, --epingler M    Épingler les processus de chaque nœud :\n"
+        << "                      proche (processeurs consécutifs) ou\n"
+        << "                      reparti (espacés sur tous les sockets)"
+        << std::endl;
+}
+
+
 /**
  * Programme principal
  */
 int main(int argc, char** argv)
 {
     int rank = 0, size = 1;
+    int intervalle = 1, halo = 1, periode = 0;
+    unsigned int nb_max_iter = NB_MAX_ITER;
+    int nb_fils = 0;
+    unsigned int synthetique[2] = {0, 0};
+    std::string sauvegarde, nom_reprise, nom_rapport;
+    int grille[2] = {0, 0};
+    Epinglage epinglage = EPINGLAGE_AUCUN;
     LePNG png;
     ModeleCTC carte_gpu;
 
+#ifdef _OPENMP
+    // Seul le fil principal appelle MPI
+    int niveau = MPI_THREAD_SINGLE;
+
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &niveau);
+#else
     MPI_Init(&argc, &argv);
+#endif
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    if (argc < 2) {
+    const double debut_total = MPI_Wtime();
+    const struct option options[] = {
+        {"intervalle", required_argument, NULL, 'c'},
+        {"halo", required_argument, NULL, 'H'},
+        {"grille", required_argument, NULL, 'g'},
+        {"sauvegarde", required_argument, NULL, 'S'},
+        {"periode", required_argument, NULL, 'P'},
+        {"reprise", required_argument, NULL, 'r'},
+        {"rapport", required_argument, NULL, 'R'},
+        {"generer", required_argument, NULL, 'G'},
+        {"iterations", required_argument, NULL, 'i'},
+        {"epingler", required_argument, NULL, 'B'},
+        {"fils", required_argument, NULL, 't'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "c:H:g:S:P:r:R:G:i:B:t:", options, NULL))
+           != -1) {
+        bool valide = true;
+
+        switch (opt) {
+        case 'c':
+            intervalle = std::atoi(optarg);
+            break;
+        case 'H':
+            halo = std::atoi(optarg);
+            break;
+        case 'g':
+            if (std::sscanf(optarg, "%dx%d", &grille[0], &grille[1]) != 2 ||
+                grille[0] < 1 || grille[1] < 1 ||
+                grille[0] * grille[1] != size) {
+                grille[0] = -1;
+            }
+            break;
+        case 'S':
+            sauvegarde = optarg;
+            break;
+        case 'P':
+            periode = std::atoi(optarg);
+            if (periode < 1)
+                periode = -1;
+            break;
+        case 'r':
+            nom_reprise = optarg;
+            break;
+        case 'R':
+            nom_rapport = optarg;
+            break;
+        case 'G':
+            valide = std::sscanf(optarg, "%ux%u", &synthetique[0],
+                                 &synthetique[1]) == 2 &&
+                synthetique[0] >= 3 && synthetique[1] >= 3;
+            break;
+        case 'i':
+            nb_max_iter = std::max(std::atoi(optarg), 0);
+            break;
+        case 't':
+            nb_fils = std::atoi(optarg);
+            valide = nb_fils >= 1;
+            break;
+        case 'B':
+            if (std::strcmp(optarg, "proche") == 0)
+                epinglage = EPINGLAGE_PROCHE;
+            else if (std::strcmp(optarg, "reparti") == 0)
+                epinglage = EPINGLAGE_REPARTI;
+            else
+                valide = false;
+            break;
+        default:
+            if (rank == 0)
+                usage(argv[0]);
+            return 1;
+        }
+
+        if (!valide || intervalle < 1 || halo < 1 || grille[0] < 0 ||
+            periode < 0 || nb_max_iter < 1) {
+            if (rank == 0)
+                std::cerr << "Erreur: valeur invalide - " << optarg
+                    << std::endl;
+            return 1;
+        }
+    }
+
+    // Une image, une sauvegarde ou une grille synthétique, une seule
+    if ((optind < argc) + !nom_reprise.empty() + (synthetique[0] > 0) != 1) {
+        if (rank == 0)
+            usage(argv[0]);
+        return 1;
+    }
+
+    if (periode > 0 && sauvegarde.empty()) {
         if (rank == 0)
-            std::cerr << "Usage: " << argv[0] << " fichier.png" << std::endl;
+            std::cerr << "Erreur: l'option --periode requiert --sauvegarde"
+                << std::endl;
         return 1;
     }
 
-    try {
-        // Charger l'image
-        std::string nom_fichier(argv[1]);
-        png.charger(nom_fichier);
+#ifdef _OPENMP
+    if (nb_fils == 0)
+        nb_fils = omp_get_max_threads();
+    if (niveau < MPI_THREAD_FUNNELED && nb_fils > 1) {
+        if (rank == 0)
+            std::cerr << "Avertissement: MPI_THREAD_FUNNELED non fourni, "
+                << "un seul fil par processus" << std::endl;
+        nb_fils = 1;
+    }
+#else
+    if (nb_fils > 1 && rank == 0) {
+        std::cerr << "Avertissement: programme compilé sans OpenMP "
+            << "(make hybride), un seul fil par processus" << std::endl;
+    }
+    nb_fils = 1;
+#endif
 
-        // Tranformer les pixels RGB en triplets CTC
-        carte_gpu.redimensionner(png.largeur(), png.hauteur());
-        std::transform(png.cbegin(), png.cend(), carte_gpu.begin(),
-            [](const png_color & pixel) {
-                return CTC {
-                    (ctc_t)pixel.red,
-                    (ctc_t)pixel.green,
-                    (ctc_t)pixel.blue / 256
-                };
-            });
+    if (!epingler_processus(epinglage, nb_fils))
+        std::cerr << "Avertissement: épinglage du processus " << rank
+            << " impossible" << std::endl;
+
+    // Seul le premier processus lit l'image ; tous lisent la sauvegarde
+    unsigned int dimensions[2] = {0, 0};
+    EnteteSauvegarde entete;
+    MPI_File reprise = MPI_FILE_NULL;
+    double debut = MPI_Wtime();
+
+    if (!nom_reprise.empty()) {
+        const std::string message =
+            ouvrir_sauvegarde(nom_reprise, MPI_COMM_WORLD, reprise, entete);
+
+        if (message.empty()) {
+            dimensions[0] = entete.largeur;
+            dimensions[1] = entete.hauteur;
+            if (rank == 0)
+                png.dimensionner(entete.largeur, entete.hauteur);
+        }
+        else if (rank == 0)
+            std::cerr << "Erreur: " << message << std::endl;
+
+        if (rank == 0 && message.empty() &&
+            ((ctc_t)entete.bruit != BRUIT ||
+             (ctc_t)entete.seuil_convergence != SEUIL_CONVERGENCE)) {
+            std::cerr << "Avertissement: bruit ou seuil différent de la "
+                << "sauvegarde" << std::endl;
+        }
     }
-    catch (const std::string message) {
+    else if (synthetique[0] > 0) {
+        dimensions[0] = synthetique[0];
+        dimensions[1] = synthetique[1];
         if (rank == 0)
+            png.dimensionner(synthetique[0], synthetique[1]);
+    }
+    else if (rank == 0) {
+        try {
+            std::string nom_fichier(argv[optind]);
+            png.charger(nom_fichier);
+
+            dimensions[0] = png.largeur();
+            dimensions[1] = png.hauteur();
+        }
+        catch (const std::string message) {
             std::cerr << "Erreur: " << message << std::endl;
+        }
+    }
+
+    MPI_Bcast(dimensions, 2, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+
+    if (dimensions[0] == 0) {
+        MPI_Finalize();
         return 2;
     }
 
-    // Boucle principale
+    // Grille cartésienne 2D de processus, non périodique
+    MPI_Comm cart;
+    int periodes[2] = {0, 0};
+
+    MPI_Dims_create(size, 2, grille);
+    MPI_Cart_create(MPI_COMM_WORLD, 2, grille, periodes, 0, &cart);
+
+    carte_gpu.fils(nb_fils);
+    carte_gpu.decouper(dimensions[0], dimensions[1], cart, halo);
+    carte_gpu.secondes(PHASE_LECTURE) += MPI_Wtime() - debut;
+
+    // Le halo doit provenir du seul processus voisin
+    if ((carte_gpu.hauteur() - 2) / grille[0] < carte_gpu.epaisseur_halo() ||
+        (carte_gpu.largeur() - 2) / grille[1] < carte_gpu.epaisseur_halo()) {
+        if (rank == 0)
+            std::cerr << "Erreur: halo trop épais pour une grille de "
+                << grille[0] << "x" << grille[1] << " processus"
+                << std::endl;
+        MPI_Finalize();
+        return 1;
+    }
+
+    // Bloc de pixels du processus courant, marges incluses
+    Tranche rangees, colonnes;
+
+    bloc(cart, rank, carte_gpu.largeur(), carte_gpu.hauteur(), true,
+        rangees, colonnes);
+
+    std::vector<png_color> pixels(
+        (rangees.fin - rangees.debut) * (colonnes.fin - colonnes.debut));
+
+    // Boucle principale, reprise là où la sauvegarde l'a laissée
     ctc_t delta_temp = SEUIL_CONVERGENCE + 1.;
     unsigned int nb_iter = 0;
 
-    while (delta_temp > SEUIL_CONVERGENCE && nb_iter < NB_MAX_ITER) {
-        delta_temp = carte_gpu.un_pas_de_temps(rank, size);
+    debut = MPI_Wtime();
+    if (!nom_reprise.empty()) {
+        // Chaque processus lit son bloc de la sauvegarde
+        reprendre(reprise, carte_gpu, cart);
+        nb_iter = entete.nb_iter;
+        delta_temp = entete.delta_temp;
+        carte_gpu.secondes(PHASE_LECTURE) += MPI_Wtime() - debut;
+    }
+    else if (synthetique[0] > 0) {
+        // Chaque processus génère son bloc, sans lecture ni distribution
+        generer(carte_gpu, rangees, colonnes);
+        carte_gpu.secondes(PHASE_CONVERSION) += MPI_Wtime() - debut;
+    }
+    else {
+        // Distribuer les blocs de l'image
+        echanger_pixels(png, pixels, cart,
+            carte_gpu.largeur(), carte_gpu.hauteur(), true);
+        carte_gpu.secondes(PHASE_DISTRIBUTION) += MPI_Wtime() - debut;
+        debut = MPI_Wtime();
+
+        // Tranformer les pixels RGB en triplets CTC
+        auto pixel = pixels.cbegin();
+
+        for (auto i = rangees.debut; i < rangees.fin; ++i) {
+            for (auto j = colonnes.debut; j < colonnes.fin; ++j, ++pixel) {
+                carte_gpu.ctc(i, j) = CTC {
+                    (ctc_t)pixel->red,
+                    (ctc_t)pixel->green,
+                    (ctc_t)pixel->blue / 256
+                };
+            }
+        }
+        carte_gpu.secondes(PHASE_CONVERSION) += MPI_Wtime() - debut;
+    }
+
+    // Remplir le halo initial
+    const unsigned int nb_iter_depart = nb_iter;
+
+    debut = MPI_Wtime();
+    carte_gpu.echanger_halo();
+
+    while (delta_temp > SEUIL_CONVERGENCE && nb_iter < nb_max_iter) {
         nb_iter++;
+
+        // Tester la convergence aux N itérations, et à la dernière
+        const bool verifier =
+            (nb_iter % intervalle == 0) || (nb_iter == nb_max_iter);
+        const ctc_t delta = carte_gpu.un_pas_de_temps(verifier);
+
+        if (verifier)
+            delta_temp = delta;
+
+        if (periode > 0 && nb_iter % periode == 0)
+            sauvegarder(sauvegarde, carte_gpu, cart, nb_iter, delta_temp,
+                        nb_max_iter);
     }
 
-    // Récupération des données
-    if (rank == 0) {
-        MPI_Status etat;
+    // Sauvegarde finale, si la dernière itération n'en a pas déjà fait une
+    if (!sauvegarde.empty() && (periode == 0 || nb_iter % periode))
+        sauvegarder(sauvegarde, carte_gpu, cart, nb_iter, delta_temp,
+                        nb_max_iter);
+    carte_gpu.secondes(PHASE_CONVERGENCE) += MPI_Wtime() - debut;
 
-        for (int r = 1; r < size; ++r) {
-            auto debut = 1 + r * (carte_gpu.hauteur() - 2) / size;
-            auto fin = 1 + (r + 1) * (carte_gpu.hauteur() - 2) / size;
+    // Calcul des températures minimale et maximale
+    debut = MPI_Wtime();
+    ctc_t t_min = carte_gpu.temperature(rangees.debut, colonnes.debut);
+    ctc_t t_max = t_min;
 
-            MPI_Recv(&carte_gpu.ctc(debut, 0),
-                (fin - debut) * carte_gpu.largeur() * 3,
-                MPI_FLOAT, r, 456, MPI_COMM_WORLD, &etat);
+    for (auto i = rangees.debut; i < rangees.fin; ++i) {
+        for (auto j = colonnes.debut; j < colonnes.fin; ++j) {
+            t_min = std::min(t_min, carte_gpu.temperature(i, j));
+            t_max = std::max(t_max, carte_gpu.temperature(i, j));
         }
     }
-    else {
-        auto debut = 1 + rank * (carte_gpu.hauteur() - 2) / size;
-        auto fin = 1 + (rank + 1) * (carte_gpu.hauteur() - 2) / size;
 
-        MPI_Send(&carte_gpu.ctc(debut, 0),
-            (fin - debut) * carte_gpu.largeur() * 3,
-            MPI_FLOAT, 0, 456, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &t_min, 1, MPI_FLOAT, MPI_MIN, cart);
+    MPI_Allreduce(MPI_IN_PLACE, &t_max, 1, MPI_FLOAT, MPI_MAX, cart);
+    carte_gpu.secondes(PHASE_MINMAX) += MPI_Wtime() - debut;
+
+    // Tranformer les températures en pixels RGB
+    debut = MPI_Wtime();
+    auto couleur = pixels.begin();
+
+    for (auto i = rangees.debut; i < rangees.fin; ++i) {
+        for (auto j = colonnes.debut; j < colonnes.fin; ++j, ++couleur) {
+            *couleur = normaliser_couleur(
+                carte_gpu.temperature(i, j), t_min, t_max);
+        }
     }
 
+    carte_gpu.secondes(PHASE_COLORATION) += MPI_Wtime() - debut;
+
+    // Récupération des données
+    debut = MPI_Wtime();
+    echanger_pixels(png, pixels, cart,
+        carte_gpu.largeur(), carte_gpu.hauteur(), false);
+    carte_gpu.secondes(PHASE_RASSEMBLEMENT) += MPI_Wtime() - debut;
+
     if (rank == 0) {
-        // Calcul et affichage de statistiques
-        const auto minmax = std::minmax_element(
-            carte_gpu.cbegin(), carte_gpu.cend(),
-            [](const CTC & a, const CTC & b) {
-                return a.temperature < b.temperature;
-            });
+        // Affichage de statistiques
         std::cout << "Itération #" << nb_iter
             << ", ajustement moyen = " << delta_temp * 256 << " / 256"
-            << ", t_min = " << minmax.first->temperature
-            << ", t_max = " << minmax.second->temperature
+            << ", t_min = " << t_min
+            << ", t_max = " << t_max
             << std::endl;
 
         try {
-            // Tranformer les températures en pixels RGB
-            std::transform(carte_gpu.cbegin(), carte_gpu.cend(), png.begin(),
-                [minmax](const CTC & ctc) {
-                    return normaliser_couleur(
-                        ctc.temperature,
-                        minmax.first->temperature,
-                        minmax.second->temperature
-                    );
-                });
-
             // Enregistrer l'image résultante
+            debut = MPI_Wtime();
             png.enregistrer("resultat.png");
+            carte_gpu.secondes(PHASE_ECRITURE) += MPI_Wtime() - debut;
         }
         catch (const std::string message) {
             std::cerr << "Erreur: " << message << std::endl;
@@ -329,6 +1726,24 @@ int main(int argc, char** argv)
         }
     }
 
+    if (!nom_rapport.empty()) {
+        std::ostringstream entree;
+
+        if (synthetique[0] > 0)
+            entree << "synthetique-" << synthetique[0] << "x" << synthetique[1];
+        else
+            entree << (nom_reprise.empty() ? argv[optind] : nom_reprise);
+
+        const Bilan bilan = {
+            entree.str(),
+            nb_iter, nb_iter - nb_iter_depart, delta_temp, t_min, t_max,
+            MPI_Wtime() - debut_total
+        };
+
+        rapporter(nom_rapport, carte_gpu, cart, grille, halo, bilan);
+    }
+
+    MPI_Comm_free(&cart);
     MPI_Finalize();
     return 0;
 }
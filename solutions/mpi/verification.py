@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""
+Vérifier que la solution MPI donne les mêmes températures quel que soit le
+découpage : chaque grille de processus (-g) et chaque profondeur de halo
+(-H) doit sauvegarder (--sauvegarde) exactement les plans d'un processus
+seul, sur une grille synthétique dont la marge n'est pas à zéro
+
+    python3 verification.py --grilles 1x2,2x2,1x4,3x3 --halos 1,2,3
+
+Le programme se termine en erreur si un plan diffère de la référence.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+
+ICI = os.path.dirname(os.path.abspath(__file__))
+TAILLE_ENTETE = 64  # En-tête des sauvegardes, suivi des plans
+
+
+def executer(args, grille, halo, dossier):
+    """
+    Exécuter la solution MPI et sauvegarder son état final
+
+    Retourne: Les plans de la sauvegarde, sans l'en-tête
+    """
+
+    p, q = (int(n) for n in grille.split("x"))
+    sauvegarde = os.path.join(dossier, f"{grille}-{halo}.ctc")
+    commande = (args.mpirun.split() + ["-np", str(p * q)] +
+                args.options_mpirun.split() +
+                [os.path.abspath(args.executable),
+                 "-G", args.grille,
+                 "-g", grille,
+                 "-i", str(args.iterations),
+                 "-H", str(halo),
+                 "-S", sauvegarde])
+
+    # resultat.png est écrit dans le dossier temporaire
+    subprocess.run(commande, cwd=dossier, check=True,
+                   stdout=subprocess.DEVNULL)
+
+    with open(sauvegarde, "rb") as fichier:
+        return fichier.read()[TAILLE_ENTETE:]
+
+
+def main():
+    analyse = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    analyse.add_argument("--grille", default="300x200",
+                         help="grille synthétique LxH (défaut 300x200)")
+    analyse.add_argument("--grilles", default="1x2,2x1,2x2,1x4,4x1,3x3",
+                         help="grilles de processus PxQ à comparer")
+    analyse.add_argument("--halos", default="1,2,3",
+                         help="profondeurs de halo à comparer")
+    analyse.add_argument("--iterations", type=int, default=30)
+    analyse.add_argument("--executable",
+                         default=os.path.join(ICI, "ecoulement"))
+    analyse.add_argument("--mpirun", default="mpirun")
+    analyse.add_argument("--options-mpirun", default="",
+                         help="par exemple \"--oversubscribe\"")
+    args = analyse.parse_args()
+
+    echecs = 0
+
+    with tempfile.TemporaryDirectory() as dossier:
+        reference = executer(args, "1x1", 1, dossier)
+
+        for grille in args.grilles.split(","):
+            for halo in args.halos.split(","):
+                identique = executer(args, grille, halo, dossier) == reference
+                echecs += not identique
+                print(f"-g {grille} -H {halo} : "
+                      f"{'identique' if identique else 'DIFFÉRENT'}")
+
+    if echecs:
+        sys.exit(f"Erreur: {echecs} découpage(s) différent(s) "
+                 f"d'un processus seul")
+
+
+if __name__ == "__main__":
+    main()